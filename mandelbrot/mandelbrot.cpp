@@ -7,6 +7,10 @@
 #include <complex>
 #include <cassert>
 #include <execution>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+#include <numeric>
 
 constexpr std::size_t max_max_iterations      = 2000;
 constexpr std::size_t max_iteration_increment = 200;
@@ -98,53 +102,77 @@ template<std::size_t Power, typename Value> constexpr auto pow(Value t_val)
   return result;
 }
 
-template<typename ComplexType, typename PowerType> constexpr auto opt_pow(const std::complex<ComplexType> &t_val, PowerType t_power)
+// The step of the escape time loop for one fixed power, so the loop itself
+// never looks at the power. visit_power picks one per frame.
+//
+// Integer powers are repeated multiplication, with closed forms for 2 and 3
+// (which the SIMD kernels below do the same way)
+template<std::size_t Power> struct IntegerPower
 {
-  if (t_power == static_cast<PowerType>(1.0)) {
-    return t_val;
-  } else if (t_power == static_cast<PowerType>(2.0)) {
-    return std::complex{ pow<2>(std::real(t_val)) - pow<2>(std::imag(t_val)), 2 * std::real(t_val) * std::imag(t_val) };
-  } else if (t_power == static_cast<decltype(t_power)>(3.0)) {
-    const auto a = std::real(t_val);
-    const auto b = std::imag(t_val);
-    return std::complex{ -3 * a * pow<2>(b) + pow<3>(a), 3 * pow<2>(a) * b - pow<3>(b) };
-    //  } else if (t_power == static_cast<decltype(t_power)>(4.0)) {
-    //    const auto a = std::real(t_val);
-    //    const auto b = std::imag(t_val);
-    //    return std::complex{ pow<4>(a) + pow<4>(b) - 6 * pow<2>(a) * pow<2>(b), 4 * pow<3>(a) * b - 4 * a * pow<3>(b) };
-  } else {
-    return std::pow(t_val, t_power);
+  template<typename ComplexType> constexpr auto operator()(const std::complex<ComplexType> &t_val, const ComplexType) const noexcept
+  {
+    if constexpr (Power == 2) {
+      return std::complex{ pow<2>(std::real(t_val)) - pow<2>(std::imag(t_val)), 2 * std::real(t_val) * std::imag(t_val) };
+    } else if constexpr (Power == 3) {
+      const auto a = std::real(t_val);
+      const auto b = std::imag(t_val);
+      return std::complex{ -3 * a * pow<2>(b) + pow<3>(a), 3 * pow<2>(a) * b - pow<3>(b) };
+    } else {
+      return pow<Power>(t_val);
+    }
   }
-}
+};
 
-template<typename PointType, typename CenterType, typename ScaleType>
-constexpr auto get_color(const Point<PointType> t_point,
-                         const Point<CenterType> t_center,
-                         const Size t_size,
-                         const ScaleType t_scale,
-                         std::size_t max_iteration,
-                         const CenterType power,
-                         const bool do_abs) noexcept
+// Any other power, in polar form: |z|^power comes from the |z|^2 the loop
+// already has for its escape check, so an iteration is one log, one atan2,
+// one exp and one sincos, instead of std::pow's detour through a complex log
+template<typename PowerType> struct PolarPower
 {
-  const std::complex scaled{ t_point.x / (t_size.width / t_scale) + (t_center.x - (t_scale / static_cast<CenterType>(2.0))),
-                             t_point.y / (t_size.height / t_scale) + (t_center.y - (t_scale / static_cast<CenterType>(2.0))) };
+  PowerType power;
+  PowerType half_power = power / 2;
 
-  auto current = scaled;
-
-  auto iteration      = 0u;
-  auto stop_iteration = max_iteration;
-
-  while (iteration < stop_iteration) {
-    if (std::norm(current) > (2.0 * 2.0) && stop_iteration == max_iteration) { stop_iteration = iteration + 5; }
+  template<typename ComplexType> auto operator()(const std::complex<ComplexType> &t_val, const ComplexType norm) const noexcept
+  {
+    const auto magnitude = std::exp(half_power * std::log(norm));
+    const auto angle     = power * std::arg(t_val);
+    return std::complex{ magnitude * std::cos(angle), magnitude * std::sin(angle) };
+  }
+};
 
-    if (do_abs) { current = std::complex{ std::abs(std::real(current)), std::abs(std::imag(current)) }; }
+template<typename PowerType> PolarPower(PowerType) -> PolarPower<PowerType>;
 
-    current = opt_pow(current, power);
-    current += scaled;
+constexpr std::size_t max_integer_power = 8;
 
-    ++iteration;
+// Calls callable with the step for power, IntegerPower<1> through
+// IntegerPower<max_integer_power> or a PolarPower
+template<typename PowerType, typename Callable> decltype(auto) visit_power(const PowerType power, Callable &&callable)
+{
+  if (power >= 1 && power <= static_cast<PowerType>(max_integer_power) && power == std::floor(power)) {
+    switch (static_cast<std::size_t>(power)) {
+    case 1: return callable(IntegerPower<1>{});
+    case 2: return callable(IntegerPower<2>{});
+    case 3: return callable(IntegerPower<3>{});
+    case 4: return callable(IntegerPower<4>{});
+    case 5: return callable(IntegerPower<5>{});
+    case 6: return callable(IntegerPower<6>{});
+    case 7: return callable(IntegerPower<7>{});
+    case 8: return callable(IntegerPower<8>{});
+    default: break;
+    }
   }
+  return callable(PolarPower{ power });
+}
 
+template<typename PointType, typename CenterType, typename ScaleType>
+constexpr auto scale_point(const Point<PointType> t_point, const Point<CenterType> t_center, const Size t_size, const ScaleType t_scale) noexcept
+{
+  return std::complex{ t_point.x / (t_size.width / t_scale) + (t_center.x - (t_scale / static_cast<CenterType>(2.0))),
+                       t_point.y / (t_size.height / t_scale) + (t_center.y - (t_scale / static_cast<CenterType>(2.0))) };
+}
+
+template<typename ValueType>
+constexpr auto escape_color(const std::size_t iteration, const std::complex<ValueType> current, const std::size_t max_iteration, const ValueType power) noexcept
+{
   if (iteration == max_iteration) {
     return Color{ 0.0, 0.0, 0.0 };
   } else {
@@ -169,6 +197,272 @@ constexpr auto get_color(const Point<PointType> t_point,
   }
 }
 
+template<typename PointType, typename CenterType, typename ScaleType, typename PowerStep>
+constexpr auto get_color(const Point<PointType> t_point,
+                         const Point<CenterType> t_center,
+                         const Size t_size,
+                         const ScaleType t_scale,
+                         std::size_t max_iteration,
+                         const CenterType power,
+                         const bool do_abs,
+                         const PowerStep power_step) noexcept
+{
+  const auto scaled = scale_point(t_point, t_center, t_size, t_scale);
+
+  auto current = scaled;
+
+  auto iteration      = 0u;
+  auto stop_iteration = max_iteration;
+
+  while (iteration < stop_iteration) {
+    const auto norm = std::norm(current);
+    if (norm > (2.0 * 2.0) && stop_iteration == max_iteration) { stop_iteration = iteration + 5; }
+
+    if (do_abs) { current = std::complex{ std::abs(std::real(current)), std::abs(std::imag(current)) }; }
+
+    current = power_step(current, norm);
+    current += scaled;
+
+    ++iteration;
+  }
+
+  return escape_color(iteration, current, max_iteration, power);
+}
+
+// get_color for several pixels at once, one pixel per SIMD lane, all lanes
+// iterating in lockstep. A lane that is done (at the same iteration
+// get_color's loop would stop at, 5 past escaping) keeps its value while the
+// others go on, so every lane stops exactly where get_color would. The
+// arithmetic is IntegerPower's, in the same order, so the pixels come out the
+// same to the bit too, as long as nothing fuses a * b + c into an fma (hence
+// -ffp-contract=off in make_mandlebrot.sh).
+//
+// Only for the powers IntegerPower has a closed form for, anything else goes
+// through get_color.
+constexpr std::size_t max_lanes = 8;
+
+template<std::size_t Count> struct Lanes;
+
+template<> struct Lanes<4>
+{
+  using doubles = double __attribute__((vector_size(4 * sizeof(double))));
+  using masks   = std::int64_t __attribute__((vector_size(4 * sizeof(double))));
+};
+
+template<> struct Lanes<8>
+{
+  using doubles = double __attribute__((vector_size(8 * sizeof(double))));
+  using masks   = std::int64_t __attribute__((vector_size(8 * sizeof(double))));
+};
+
+using EscapeFunction = void (*)(const double *t_real,
+                                const double *t_imag,
+                                std::size_t max_iteration,
+                                bool do_abs,
+                                std::size_t *iterations,
+                                double *final_real,
+                                double *final_imag);
+
+struct EscapeKernel
+{
+  std::size_t lanes       = 1;
+  EscapeFunction function = nullptr;
+};
+
+// IntegerPower's closed forms, on all lanes at once
+template<int Power, typename Doubles> [[gnu::always_inline]] inline void pow_lanes(Doubles &real, Doubles &imag) noexcept
+{
+  const auto a = real;
+  const auto b = imag;
+  if constexpr (Power == 2) {
+    real = a * a - b * b;
+    imag = 2.0 * a * b;
+  } else {
+    static_assert(Power == 3);
+    real = -3.0 * a * (b * b) + a * a * a;
+    imag = 3.0 * (a * a) * b - b * b * b;
+  }
+}
+
+template<typename Doubles, typename Masks> [[gnu::always_inline]] inline void abs_lanes(Doubles &values) noexcept
+{
+  values = reinterpret_cast<Doubles>(reinterpret_cast<Masks>(values) & std::numeric_limits<std::int64_t>::max());
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+// The lockstep loop is written out in each of these instead of being shared,
+// gcc would compile a shared one for the baseline instruction set and split
+// every vector comparison back up into one per lane
+template<int Power>
+__attribute__((target("avx"))) void escape_avx(const double *t_real,
+                                               const double *t_imag,
+                                               const std::size_t max_iteration,
+                                               const bool do_abs,
+                                               std::size_t *iterations,
+                                               double *final_real,
+                                               double *final_imag)
+{
+  using Doubles = Lanes<4>::doubles;
+  using Masks   = Lanes<4>::masks;
+
+  Doubles scaled_real;
+  Doubles scaled_imag;
+  std::memcpy(&scaled_real, t_real, sizeof(scaled_real));
+  std::memcpy(&scaled_imag, t_imag, sizeof(scaled_imag));
+
+  auto real = scaled_real;
+  auto imag = scaled_imag;
+
+  // iteration counts as doubles (exact this far below 2^53), so the masks
+  // all come from comparisons of the same width
+  const auto max      = Doubles{} + static_cast<double>(max_iteration);
+  auto stop_iteration = max;
+  auto iteration      = Doubles{};
+
+  for (;;) {
+    const Masks running = iteration < stop_iteration;
+    if (!(running[0] | running[1] | running[2] | running[3])) { break; }
+
+    const Masks escaping = running & (real * real + imag * imag > (2.0 * 2.0)) & (stop_iteration == max);
+    stop_iteration       = escaping ? iteration + 5.0 : stop_iteration;
+
+    auto next_real = real;
+    auto next_imag = imag;
+    if (do_abs) {
+      abs_lanes<Doubles, Masks>(next_real);
+      abs_lanes<Doubles, Masks>(next_imag);
+    }
+    pow_lanes<Power>(next_real, next_imag);
+    next_real += scaled_real;
+    next_imag += scaled_imag;
+
+    real = running ? next_real : real;
+    imag = running ? next_imag : imag;
+    iteration += 1.0;
+  }
+
+  for (std::size_t lane = 0; lane < 4; ++lane) {
+    iterations[lane] = static_cast<std::size_t>(stop_iteration[lane]);
+    final_real[lane] = real[lane];
+    final_imag[lane] = imag[lane];
+  }
+}
+
+template<int Power>
+__attribute__((target("avx512f"))) void escape_avx512(const double *t_real,
+                                                      const double *t_imag,
+                                                      const std::size_t max_iteration,
+                                                      const bool do_abs,
+                                                      std::size_t *iterations,
+                                                      double *final_real,
+                                                      double *final_imag)
+{
+  using Doubles = Lanes<8>::doubles;
+  using Masks   = Lanes<8>::masks;
+
+  Doubles scaled_real;
+  Doubles scaled_imag;
+  std::memcpy(&scaled_real, t_real, sizeof(scaled_real));
+  std::memcpy(&scaled_imag, t_imag, sizeof(scaled_imag));
+
+  auto real = scaled_real;
+  auto imag = scaled_imag;
+
+  const auto max      = Doubles{} + static_cast<double>(max_iteration);
+  auto stop_iteration = max;
+  auto iteration      = Doubles{};
+
+  for (;;) {
+    // all lanes done is the same as the latest stop being reached
+    const Masks running = iteration < stop_iteration;
+    if (!(running[0] | running[1] | running[2] | running[3] | running[4] | running[5] | running[6] | running[7])) { break; }
+
+    const Masks escaping = running & (real * real + imag * imag > (2.0 * 2.0)) & (stop_iteration == max);
+    stop_iteration       = escaping ? iteration + 5.0 : stop_iteration;
+
+    auto next_real = real;
+    auto next_imag = imag;
+    if (do_abs) {
+      abs_lanes<Doubles, Masks>(next_real);
+      abs_lanes<Doubles, Masks>(next_imag);
+    }
+    pow_lanes<Power>(next_real, next_imag);
+    next_real += scaled_real;
+    next_imag += scaled_imag;
+
+    real = running ? next_real : real;
+    imag = running ? next_imag : imag;
+    iteration += 1.0;
+  }
+
+  for (std::size_t lane = 0; lane < 8; ++lane) {
+    iterations[lane] = static_cast<std::size_t>(stop_iteration[lane]);
+    final_real[lane] = real[lane];
+    final_imag[lane] = imag[lane];
+  }
+}
+#endif
+
+// The widest kernel this CPU can run for this power, or none (lanes == 1)
+// to use get_color for every pixel
+inline EscapeKernel select_escape_kernel(const double power)
+{
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  const auto for_power = [power](auto escape) -> EscapeFunction {
+    if (power == 2.0) { return escape.template operator()<2>(); }
+    if (power == 3.0) { return escape.template operator()<3>(); }
+    return nullptr;
+  };
+
+  if (__builtin_cpu_supports("avx512f")) {
+    if (const auto function = for_power([]<int Power>() { return &escape_avx512<Power>; })) { return { 8, function }; }
+  } else if (__builtin_cpu_supports("avx")) {
+    if (const auto function = for_power([]<int Power>() { return &escape_avx<Power>; })) { return { 4, function }; }
+  }
+#else
+  static_cast<void>(power);
+#endif
+  return {};
+}
+
+// One row of the image, kernel.lanes pixels at a time as far as that goes
+template<std::size_t Width, typename PowerStep>
+void render_row(Color<double> *row,
+                const std::size_t y,
+                const Settings &settings,
+                const Size size,
+                const std::size_t max_iteration,
+                const EscapeKernel kernel,
+                const PowerStep power_step) noexcept
+{
+  const auto simd_end = kernel.function == nullptr ? 0 : Width - Width % kernel.lanes;
+
+  std::size_t x = 0;
+  for (; x < simd_end; x += kernel.lanes) {
+    std::array<double, max_lanes> real{};
+    std::array<double, max_lanes> imag{};
+    std::array<std::size_t, max_lanes> iterations{};
+    std::array<double, max_lanes> final_real{};
+    std::array<double, max_lanes> final_imag{};
+
+    for (std::size_t lane = 0; lane < kernel.lanes; ++lane) {
+      const auto scaled = scale_point(Point{ x + lane, y }, settings.center, size, settings.scale);
+      real[lane]        = std::real(scaled);
+      imag[lane]        = std::imag(scaled);
+    }
+
+    kernel.function(real.data(), imag.data(), max_iteration, settings.do_abs, iterations.data(), final_real.data(), final_imag.data());
+
+    for (std::size_t lane = 0; lane < kernel.lanes; ++lane) {
+      row[x + lane] = escape_color(iterations[lane], std::complex{ final_real[lane], final_imag[lane] }, max_iteration, settings.power);
+    }
+  }
+
+  for (; x < Width; ++x) {
+    row[x] = get_color(Point{ x, y }, settings.center, size, settings.scale, max_iteration, settings.power, settings.do_abs, power_step);
+  }
+}
+
 template<typename PointType, typename ColorType> void set_pixel(sf::Image &img, const Point<PointType> &t_point, const Color<ColorType> &t_color)
 {
   const auto to_sf_color = [](const auto &color) {
@@ -187,11 +481,11 @@ template<std::size_t Width, std::size_t Height> struct Image
   //  auto &operator
 };
 
-template<std::size_t Width, std::size_t Height> constexpr auto get_indicies()
+template<std::size_t Height> constexpr auto get_rows()
 {
-  std::array<std::pair<std::size_t, std::size_t>, Width * Height> indicies{};
-  std::generate(begin(indicies), end(indicies), [index = begin(Size{ Width, Height })]() mutable { return *(index++); });
-  return indicies;
+  std::array<std::size_t, Height> rows{};
+  std::iota(begin(rows), end(rows), std::size_t{ 0 });
+  return rows;
 }
 
 // this entire interface should be redesigned, it's really not safe, but it
@@ -200,7 +494,7 @@ template<std::size_t Width, std::size_t Height> void run(Image<Width, Height> *i
 {
   auto localImg                  = std::make_unique<Image<Width, Height>>(*img);
   auto settings                  = *global_settings;
-  static constexpr auto indicies = get_indicies<Width, Height>();
+  static constexpr auto rows     = get_rows<Height>();
 
   auto cur_max_iterations = settings.cur_max_iterations;
 
@@ -209,9 +503,13 @@ template<std::size_t Width, std::size_t Height> void run(Image<Width, Height> *i
 
     if (cur_max_iterations <= max_max_iterations) {
       constexpr Size size{ Width, Height };
-      std::transform(std::execution::par_unseq, begin(indicies), end(indicies), begin(localImg->colors), [=](const auto &location) {
-        return get_color(
-          Point{ location.first, location.second }, settings.center, size, settings.scale, cur_max_iterations, settings.power, settings.do_abs);
+      // picked once per frame, settings.power can change between frames
+      const auto kernel = select_escape_kernel(settings.power);
+      auto *colors      = localImg->colors.data();
+      visit_power(settings.power, [&](const auto power_step) {
+        std::for_each(std::execution::par_unseq, begin(rows), end(rows), [=](const std::size_t row) {
+          render_row<Width>(colors + row * Width, row, settings, size, cur_max_iterations, kernel, power_step);
+        });
       });
 
       // this is almost certainly UB, writing into shared data with no mutexes at all
@@ -288,6 +586,9 @@ int main()
         } else {
           settings.power -= 0.1;
         }
+        // back on a whole number of tenths, so stepping back to an integer
+        // power lands on it exactly and gets its IntegerPower
+        settings.power = std::round(settings.power * 10.0) / 10.0;
       }
       if (sf::Keyboard::isKeyPressed(sf::Keyboard::A)) { settings.do_abs = !settings.do_abs; }
 
@@ -0,0 +1,127 @@
+#ifndef CPP_WEEKLY_ACTIVE_BOARD_HPP
+#define CPP_WEEKLY_ACTIVE_BOARD_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <execution>
+
+#include "tiled_board.hpp"
+
+// A byte-per-cell board (GameBoard) that also remembers which tiles
+// changed in the generation that produced it.
+//
+// A tile can only change if something in it or in one of its 8 neighboring
+// tiles changed last generation, so everything else is skipped. With a
+// couple of gliders on a 10000x10000 board nearly every tile is skipped,
+// and the stepping cost scales with the activity instead of the area.
+//
+// Skipped tiles are not written at all: since they did not change last
+// generation either, the older generation still sitting in the output
+// buffer (we ping-pong between two boards) is already correct. This means
+// the board must be stepped back and forth with the same partner board.
+template <typename BoardType, std::size_t TileWidth = 64,
+          std::size_t TileHeight = 64>
+struct ActiveBoard : BoardType {
+  static constexpr auto board_width = static_cast<std::size_t>(BoardType::width);
+  static constexpr auto board_height =
+      static_cast<std::size_t>(BoardType::height);
+
+  static constexpr std::size_t tile_width = TileWidth;
+  static constexpr std::size_t tile_height = TileHeight;
+  static constexpr std::size_t tiles_x =
+      (board_width + TileWidth - 1) / TileWidth;
+  static constexpr std::size_t tiles_y =
+      (board_height + TileHeight - 1) / TileHeight;
+
+  // One flag per tile. Not a std::bitset, because each row of tiles is
+  // written from a different thread.
+  // Everything starts out as changed, so the first steps compute it all.
+  std::array<bool, tiles_x * tiles_y> changed_tiles = [] {
+    std::array<bool, tiles_x * tiles_y> result{};
+    result.fill(true);
+    return result;
+  }();
+
+  static constexpr auto tile_rows = [] {
+    std::array<std::uint32_t, tiles_y> result{};
+    for (std::size_t tile_y = 0; tile_y < tiles_y; ++tile_y) {
+      result[tile_y] = static_cast<std::uint32_t>(tile_y);
+    }
+    return result;
+  }();
+
+  // Does anything in this tile or around it need to be recomputed?
+  [[nodiscard]] constexpr bool is_active(std::size_t tile_x,
+                                         std::size_t tile_y) const {
+    for (const auto offset_y : {tiles_y - 1, std::size_t{0}, std::size_t{1}}) {
+      const auto y = (tile_y + offset_y) % tiles_y;
+      for (const auto offset_x :
+           {tiles_x - 1, std::size_t{0}, std::size_t{1}}) {
+        if (changed_tiles[y * tiles_x + (tile_x + offset_x) % tiles_x]) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+};
+
+// Computes one tile, returns true if anything in it changed
+template <typename BoardType>
+constexpr bool iterate_active_tile(const BoardType &input, BoardType &output,
+                                   std::size_t tile_x, std::size_t tile_y) {
+  constexpr auto width = BoardType::board_width;
+  constexpr auto height = BoardType::board_height;
+
+  const auto first_x = tile_x * BoardType::tile_width;
+  const auto last_x = std::min(first_x + BoardType::tile_width, width);
+  const auto first_y = tile_y * BoardType::tile_height;
+  const auto last_y = std::min(first_y + BoardType::tile_height, height);
+
+  const auto row = [](auto &board, std::size_t y) {
+    return board.data.data() + y * width;
+  };
+
+  bool changed = false;
+  for (std::size_t y = first_y; y < last_y; ++y) {
+    const auto above = y == 0 ? height - 1 : y - 1;
+    const auto below = y == height - 1 ? 0 : y + 1;
+
+    iterate_dense_row_range(row(input, above), row(input, y),
+                            row(input, below), row(output, y), width, first_x,
+                            last_x);
+    changed = changed || !std::equal(row(input, y) + first_x,
+                                     row(input, y) + last_x,
+                                     row(output, y) + first_x);
+  }
+  return changed;
+}
+
+template <typename BoardType>
+constexpr void iterate_board_active(const BoardType &input,
+                                    BoardType &output) {
+  const auto step_tile_row = [&](const auto tile_y) {
+    for (std::size_t tile_x = 0; tile_x < BoardType::tiles_x; ++tile_x) {
+      const auto tile = tile_y * BoardType::tiles_x + tile_x;
+      output.changed_tiles[tile] =
+          input.is_active(tile_x, tile_y) &&
+          iterate_active_tile(input, output, tile_x, tile_y);
+    }
+  };
+
+#ifndef SERIAL
+  if consteval {
+#endif
+    std::for_each(BoardType::tile_rows.begin(), BoardType::tile_rows.end(),
+                  step_tile_row);
+#ifndef SERIAL
+  } else {
+    std::for_each(std::execution::par_unseq, BoardType::tile_rows.begin(),
+                  BoardType::tile_rows.end(), step_tile_row);
+  }
+#endif
+}
+
+#endif
@@ -0,0 +1,211 @@
+#ifndef CPP_WEEKLY_BIT_BOARD_HPP
+#define CPP_WEEKLY_BIT_BOARD_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <execution>
+#include <numeric>
+
+// A bit-packed alternative to GameBoard: one std::uint64_t holds 64 cells
+// of a row, so a 10000x10000 board is 12.5MB instead of 100MB.
+//
+// Each row is padded up to a whole number of words, and the padding bits
+// are always kept at 0, which makes the wraparound at the right edge
+// a single shift.
+template <std::size_t Width, std::size_t Height> struct BitBoard {
+  using word_t = std::uint64_t;
+
+  static constexpr std::size_t bits_per_word = 64;
+  static constexpr std::size_t width = Width;
+  static constexpr std::size_t height = Height;
+  static constexpr std::size_t words_per_row =
+      (Width + bits_per_word - 1) / bits_per_word;
+
+  // number of valid cells in the last word of each row
+  static constexpr std::size_t last_word_bits =
+      Width - (words_per_row - 1) * bits_per_word;
+  static constexpr word_t last_word_mask =
+      last_word_bits == bits_per_word ? ~word_t{0}
+                                      : (word_t{1} << last_word_bits) - 1;
+
+  std::array<word_t, words_per_row * Height> data{};
+
+  struct Point {
+    std::ptrdiff_t x;
+    std::ptrdiff_t y;
+    [[nodiscard]] constexpr Point operator+(Point rhs) const {
+      return Point{x + rhs.x, y + rhs.y};
+    }
+  };
+
+  // Row numbers are what gets handed out to the parallel algorithm,
+  // Height entries instead of one Point per cell
+  static constexpr auto rows = [] {
+    std::array<std::uint32_t, Height> result{};
+    std::iota(result.begin(), result.end(), std::uint32_t{0});
+    return result;
+  }();
+
+  [[nodiscard]] constexpr static Point wrap(Point p) {
+    constexpr auto w = static_cast<std::ptrdiff_t>(Width);
+    constexpr auto h = static_cast<std::ptrdiff_t>(Height);
+    return Point{((p.x % w) + w) % w, ((p.y % h) + h) % h};
+  }
+
+  [[nodiscard]] constexpr const word_t *row(std::size_t y) const {
+    return data.data() + y * words_per_row;
+  }
+
+  [[nodiscard]] constexpr word_t *row(std::size_t y) {
+    return data.data() + y * words_per_row;
+  }
+
+  [[nodiscard]] constexpr bool operator[](Point p) const noexcept {
+    const auto wrapped = wrap(p);
+    const auto x = static_cast<std::size_t>(wrapped.x);
+    return (row(static_cast<std::size_t>(wrapped.y))[x / bits_per_word] >>
+            (x % bits_per_word)) &
+           1;
+  }
+
+  constexpr void set(Point p) noexcept {
+    const auto wrapped = wrap(p);
+    const auto x = static_cast<std::size_t>(wrapped.x);
+    row(static_cast<std::size_t>(wrapped.y))[x / bits_per_word] |=
+        word_t{1} << (x % bits_per_word);
+  }
+
+  // Copy in any board that can be indexed with a Point (ie GameBoard)
+  template <typename OtherBoard> constexpr void load(const OtherBoard &other) {
+    data.fill(0);
+    for (std::size_t y = 0; y < Height; ++y) {
+      for (std::size_t x = 0; x < Width; ++x) {
+        if (other[typename OtherBoard::Point(x, y)]) {
+          set(Point(static_cast<std::ptrdiff_t>(x),
+                    static_cast<std::ptrdiff_t>(y)));
+        }
+      }
+    }
+  }
+
+  constexpr void add_glider(Point p) {
+    set(p);
+    set(p + Point{1, 1});
+    set(p + Point{2, 1});
+    set(p + Point{0, 2});
+    set(p + Point{1, 2});
+  }
+};
+
+// The 3 horizontally adjacent versions of a word: the cells themselves,
+// every cell's west neighbor and every cell's east neighbor, lined up
+// on the same bit positions.
+struct ShiftedWords {
+  std::uint64_t west;
+  std::uint64_t center;
+  std::uint64_t east;
+};
+
+template <typename BoardType>
+[[nodiscard]] constexpr ShiftedWords
+shifted_words(const typename BoardType::word_t *row, std::size_t word) {
+  constexpr auto last_word = BoardType::words_per_row - 1;
+  constexpr auto last_bit = BoardType::last_word_bits - 1;
+
+  const auto center = row[word];
+
+  // bit 0 takes its west neighbor from the top bit of the previous word,
+  // or from the last cell of the row when wrapping around
+  const auto west_carry =
+      word == 0 ? (row[last_word] >> last_bit) & 1 : row[word - 1] >> 63;
+
+  // and the last valid bit takes its east neighbor from the next word, or
+  // from cell 0 when wrapping around
+  const auto east_carry = word == last_word ? (row[0] & 1) << last_bit
+                                            : row[word + 1] << 63;
+
+  return ShiftedWords{(center << 1) | west_carry, center,
+                      (center >> 1) | east_carry};
+}
+
+// Computes a whole word (64 cells) of the next generation at once.
+//
+// The 8 neighbor bits of every cell are summed with a bit-sliced adder:
+// each row contributes a 2 bit partial count, and those are combined into
+// the ones bit and the twos bit of the total. A count of 8 wraps around to
+// 0, which is fine because 8 neighbors is dead anyway.
+[[nodiscard]] constexpr std::uint64_t next_word(const ShiftedWords &above,
+                                                const ShiftedWords &middle,
+                                                const ShiftedWords &below) {
+  // row above: 3 cells -> sum (ones) + carry (twos)
+  const auto above_ones = above.west ^ above.center ^ above.east;
+  const auto above_twos = (above.west & above.center) |
+                          (above.east & (above.west ^ above.center));
+
+  // own row: only 2 neighbors, the center is the cell itself
+  const auto middle_ones = middle.west ^ middle.east;
+  const auto middle_twos = middle.west & middle.east;
+
+  const auto below_ones = below.west ^ below.center ^ below.east;
+  const auto below_twos = (below.west & below.center) |
+                          (below.east & (below.west ^ below.center));
+
+  // add up the 3 ones bits, the carry moves into the twos column
+  const auto ones = above_ones ^ middle_ones ^ below_ones;
+  const auto ones_carry = (above_ones & middle_ones) |
+                          (below_ones & (above_ones ^ middle_ones));
+
+  // we have 4 bits in the twos column, the count is 2 or 3 only if
+  // exactly one of them is set
+  const auto twos_a = above_twos ^ middle_twos;
+  const auto twos_b = below_twos ^ ones_carry;
+  const auto twos_overflow = (above_twos & middle_twos) |
+                             (below_twos & ones_carry);
+  const auto exactly_one_two = (twos_a ^ twos_b) & ~twos_overflow;
+
+  // 3 neighbors: born or survives; 2 neighbors: survives only
+  return exactly_one_two & (ones | middle.center);
+}
+
+template <typename BoardType>
+constexpr void iterate_bit_row(const BoardType &input, BoardType &output,
+                               std::size_t y) {
+  constexpr auto height = BoardType::height;
+  constexpr auto last_word = BoardType::words_per_row - 1;
+
+  const auto *above = input.row((y + height - 1) % height);
+  const auto *middle = input.row(y);
+  const auto *below = input.row((y + 1) % height);
+  auto *result = output.row(y);
+
+  for (std::size_t word = 0; word <= last_word; ++word) {
+    result[word] = next_word(shifted_words<BoardType>(above, word),
+                             shifted_words<BoardType>(middle, word),
+                             shifted_words<BoardType>(below, word));
+  }
+
+  // keep the padding bits cleared, the wraparound relies on it
+  result[last_word] &= BoardType::last_word_mask;
+}
+
+template <typename BoardType>
+constexpr void iterate_bit_board(const BoardType &input, BoardType &output) {
+  const auto step_row = [&](const auto y) {
+    iterate_bit_row(input, output, y);
+  };
+
+#ifndef SERIAL
+  if consteval {
+#endif
+    std::for_each(BoardType::rows.begin(), BoardType::rows.end(), step_row);
+#ifndef SERIAL
+  } else {
+    std::for_each(std::execution::par_unseq, BoardType::rows.begin(),
+                  BoardType::rows.end(), step_row);
+  }
+#endif
+}
+
+#endif
@@ -0,0 +1,225 @@
+#!/usr/bin/env python3
+"""Summarizes performance_stats.csv, and finds regressions between versions.
+
+With no SHAs, every (SHA, compiler, flags) configuration is summarized: run
+count, median, MAD and a confidence interval for the median of one metric.
+
+With two SHAs (or unique prefixes of them, as written by
+run_performance_tests.sh), every configuration measured for both is
+compared. A configuration regressed when the whole confidence interval for
+new median / base median is above 1 + threshold, so a change has to be both
+bigger than the threshold and bigger than the noise between runs. The exit
+status is 1 if anything regressed (and 2 if the comparison could not be
+made), so this can gate a merge:
+
+    ./run_performance_tests.sh game_of_life.cpp 5 -std=c++23 -ltbb
+    ./compare_performance.py 7079af1a e204e658
+
+Only the standard library is used, so it runs wherever the sweep does.
+"""
+
+import argparse
+import csv
+import math
+import random
+import statistics
+import sys
+
+# Everything that makes two rows measurements of the same thing, besides SHA
+CONFIGURATION_COLUMNS = (
+    "Compiler",
+    "Version",
+    "Optimization",
+    "Architecture",
+    "Additional Flags",
+    "Stdlib",
+    "CPU Model",
+    "Virtualization Type",
+)
+
+
+def fail(message):
+    print(message, file=sys.stderr)
+    sys.exit(2)
+
+
+def parse_value(text):
+    text = text.strip().rstrip("%")
+    if not text:
+        return None
+    try:
+        return float(text)
+    except ValueError:
+        return None
+
+
+def load_groups(path, metric):
+    """{(sha, configuration): [values of metric]}, in file order"""
+    groups = {}
+    with open(path, newline="") as file:
+        reader = csv.DictReader(file)
+        if metric not in (reader.fieldnames or []):
+            fail(f"{path} has no column '{metric}'")
+        for row in reader:
+            value = parse_value(row[metric])
+            if value is None:
+                continue
+            configuration = tuple(row[column] for column in CONFIGURATION_COLUMNS)
+            groups.setdefault((row["SHA"], configuration), []).append(value)
+    return groups
+
+
+def mad(values):
+    """Median absolute deviation, scaled to estimate the standard deviation"""
+    median = statistics.median(values)
+    return 1.4826 * statistics.median(abs(value - median) for value in values)
+
+
+def median_interval(values, confidence):
+    """Distribution free confidence interval for the median, from order
+    statistics. With too few runs for the confidence asked for, this is just
+    the range of the runs."""
+    ordered = sorted(values)
+    n = len(ordered)
+    alpha = 1 - confidence
+    # the largest k with P(Binomial(n, 1/2) < k) <= alpha / 2
+    k = 0
+    below = 0.0
+    while k < n:
+        below += math.comb(n, k) / 2**n
+        if below > alpha / 2:
+            break
+        k += 1
+    if k == 0:
+        return ordered[0], ordered[-1]
+    return ordered[k - 1], ordered[n - k]
+
+
+def ratio_interval(base, new, confidence, resamples, rng):
+    """Bootstrap confidence interval for median(new) / median(base)"""
+    ratios = sorted(
+        statistics.median(rng.choices(new, k=len(new)))
+        / statistics.median(rng.choices(base, k=len(base)))
+        for _ in range(resamples)
+    )
+    alpha = 1 - confidence
+    low = ratios[int(alpha / 2 * (resamples - 1))]
+    high = ratios[int((1 - alpha / 2) * (resamples - 1))]
+    return low, high
+
+
+def describe(configuration):
+    fields = dict(zip(CONFIGURATION_COLUMNS, configuration))
+    parts = [fields["Compiler"], fields["Optimization"]]
+    for column in ("Architecture", "Additional Flags"):
+        if fields[column]:
+            parts.append(fields[column])
+    if fields["Stdlib"]:
+        parts.append(fields["Stdlib"])
+    return " ".join(parts) + f" [{fields['Version']}, {fields['CPU Model']}]"
+
+
+def find_sha(groups, prefix):
+    matches = sorted({sha for sha, _ in groups if sha.startswith(prefix)})
+    if not matches:
+        fail(f"no rows with a SHA starting with '{prefix}'")
+    if len(matches) > 1:
+        fail(f"'{prefix}' matches more than one SHA: {', '.join(matches)}")
+    return matches[0]
+
+
+def summarize(groups, args):
+    for (sha, configuration), values in sorted(groups.items()):
+        low, high = median_interval(values, args.confidence)
+        print(
+            f"{sha[:12]} {describe(configuration)}\n"
+            f"    runs: {len(values)}, median: {statistics.median(values):.6g}, "
+            f"MAD: {mad(values):.6g}, "
+            f"{args.confidence:.0%} CI: [{low:.6g}, {high:.6g}]"
+        )
+    return 0
+
+
+def compare(groups, args):
+    base_sha = find_sha(groups, args.base)
+    new_sha = find_sha(groups, args.new)
+    base = {config: values for (sha, config), values in groups.items() if sha == base_sha}
+    new = {config: values for (sha, config), values in groups.items() if sha == new_sha}
+    common = sorted(base.keys() & new.keys())
+    if not common:
+        fail(f"{base_sha[:12]} and {new_sha[:12]} have no configuration in common")
+
+    print(f"{args.metric}: {base_sha[:12]} -> {new_sha[:12]}, lower is better")
+
+    rng = random.Random(args.seed)
+    regressions = 0
+    for configuration in common:
+        base_values = base[configuration]
+        new_values = new[configuration]
+        change = statistics.median(new_values) / statistics.median(base_values) - 1
+
+        if min(len(base_values), len(new_values)) < args.min_runs:
+            verdict = f"too few runs ({len(base_values)} vs {len(new_values)})"
+        else:
+            low, high = ratio_interval(
+                base_values, new_values, args.confidence, args.resamples, rng
+            )
+            interval = f"CI [{low - 1:+.1%}, {high - 1:+.1%}]"
+            if low > 1 + args.threshold:
+                verdict = f"REGRESSION, {interval}"
+                regressions += 1
+            elif high < 1 - args.threshold:
+                verdict = f"improvement, {interval}"
+            else:
+                verdict = f"no significant change, {interval}"
+
+        print(f"  {change:+7.1%}  {describe(configuration)}: {verdict}")
+
+    for label, only in (("base", base.keys() - new.keys()), ("new", new.keys() - base.keys())):
+        if only:
+            print(f"  ({len(only)} configurations only measured for the {label} SHA)")
+
+    if regressions:
+        print(f"{regressions} of {len(common)} configurations regressed")
+        return 1
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("base", nargs="?", help="SHA (or a prefix) to compare against")
+    parser.add_argument("new", nargs="?", help="SHA (or a prefix) to check for regressions")
+    parser.add_argument("--csv", default="performance_stats.csv")
+    parser.add_argument(
+        "--metric",
+        default="Time (ms)",
+        help="column to compare, where lower is better (default: %(default)s)",
+    )
+    parser.add_argument(
+        "--threshold",
+        type=float,
+        default=0.02,
+        help="smallest slowdown that counts, as a fraction (default: %(default)s)",
+    )
+    parser.add_argument("--confidence", type=float, default=0.95)
+    parser.add_argument(
+        "--min-runs",
+        type=int,
+        default=3,
+        help="configurations with fewer runs on either side are only reported",
+    )
+    parser.add_argument("--resamples", type=int, default=10000)
+    parser.add_argument("--seed", type=int, default=0)
+    args = parser.parse_args()
+
+    if (args.base is None) != (args.new is None):
+        parser.error("give either no SHAs, or a base and a new SHA")
+
+    groups = load_groups(args.csv, args.metric)
+    if args.base is None:
+        return summarize(groups, args)
+    return compare(groups, args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
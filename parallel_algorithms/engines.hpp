@@ -0,0 +1,440 @@
+#ifndef CPP_WEEKLY_ENGINES_HPP
+#define CPP_WEEKLY_ENGINES_HPP
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "active_board.hpp"
+#include "bit_board.hpp"
+#include "game_board.hpp"
+#include "hashlife.hpp"
+#include "life_rule.hpp"
+#include "lookup_board.hpp"
+#include "numa.hpp"
+#include "simd_row.hpp"
+#include "temporal_board.hpp"
+#include "thread_pool.hpp"
+#include "tiled_board.hpp"
+#include "worker_team.hpp"
+
+// An engine bundles a board storage type with the way it is stepped,
+// so that run_board can time each of them with identical setup and output.
+//
+// The default engine: one bool per cell, one Point per cell.
+template <std::size_t Width, std::size_t Height> struct DenseEngine {
+  using board_type = GameBoard<Width, Height>;
+  static constexpr std::string_view name = "dense";
+
+  std::unique_ptr<std::array<typename board_type::Point, Width * Height>>
+      indices = board_type::make_indexes();
+
+  void step(const board_type &input, board_type &output) {
+    iterate_board(input, output, *indices);
+  }
+};
+
+// 64 cells per word, a whole word of cells computed at once
+template <std::size_t Width, std::size_t Height> struct BitPackedEngine {
+  using board_type = BitBoard<Width, Height>;
+  static constexpr std::string_view name = "bit_packed";
+
+  void step(const board_type &input, board_type &output) {
+    iterate_bit_board(input, output);
+  }
+};
+
+// Same storage as DenseEngine, but stepped in L2 sized bands of rows
+// with no per-cell index array and no per-cell modulo
+template <std::size_t Width, std::size_t Height> struct TiledEngine {
+  using board_type = GameBoard<Width, Height>;
+  static constexpr std::string_view name = "tiled";
+
+  void step(const board_type &input, board_type &output) {
+    iterate_board_tiled(input, output);
+  }
+};
+
+// Tiled, with the next state of every 3x3 neighborhood looked up in a
+// 512 entry table instead of counting neighbors
+template <std::size_t Width, std::size_t Height> struct LookupEngine {
+  using board_type = GameBoard<Width, Height>;
+  static constexpr std::string_view name = "lookup";
+
+  void step(const board_type &input, board_type &output) {
+    iterate_board_tiled(input, output, LookupRowKernel{});
+  }
+};
+
+// Only tiles where something changed last generation (or next to one)
+// are recomputed
+template <std::size_t Width, std::size_t Height> struct ActiveEngine {
+  using board_type = ActiveBoard<GameBoard<Width, Height>>;
+  static constexpr std::string_view name = "active";
+
+  void step(const board_type &input, board_type &output) {
+    iterate_board_active(input, output);
+  }
+};
+
+// GOL_RULE=<rulestring> (B36/S23) or GOL_RULE=<name> (highlife, see
+// known_rules) picks the rule of the rules and simd engines, Conway by
+// default
+[[nodiscard]] inline LifeRule selected_rule() {
+  const auto *rulestring = std::getenv("GOL_RULE");
+  if (rulestring == nullptr) {
+    return conway_rule;
+  }
+
+  for (const auto &known : known_rules) {
+    if (known.name == rulestring) {
+      return known.rule;
+    }
+  }
+  if (const auto rule = parse_rule(rulestring)) {
+    return *rule;
+  }
+  throw std::invalid_argument(std::string{"GOL_RULE is not a rule: "} +
+                              rulestring);
+}
+
+// Tiled, with a hand written AVX2 / AVX-512 row kernel picked at runtime.
+// Follows GOL_RULE like the rules engine.
+template <std::size_t Width, std::size_t Height> struct SimdEngine {
+  using board_type = GameBoard<Width, Height>;
+  static constexpr std::string_view name = "simd";
+
+  LifeRule rule = selected_rule();
+  SimdRowKernel kernel{rule};
+
+  void step(const board_type &input, board_type &output) {
+    iterate_board_tiled(input, output, kernel);
+  }
+
+  void report() const {
+    std::cout << "  Rule: " << to_string(rule) << ", "
+              << to_string(kernel.level) << '\n';
+  }
+};
+
+// The value of environment variable `name`, which has to be a positive
+// number if it is set at all
+[[nodiscard]] inline std::optional<std::size_t>
+positive_env(const char *name) {
+  const auto *value = std::getenv(name);
+  if (value == nullptr) {
+    return std::nullopt;
+  }
+  const std::string_view text{value};
+  std::size_t result = 0;
+  const auto [end, error] =
+      std::from_chars(text.data(), text.data() + text.size(), result);
+  if (error != std::errc{} || end != text.data() + text.size() ||
+      result == 0) {
+    throw std::invalid_argument(std::string{name} +
+                                " is not a positive number: " + value);
+  }
+  return result;
+}
+
+// GOL_THREADS=<n> sets the thread count of the pool engines (default: all
+// hardware threads), GOL_PIN_THREADS=1 pins worker i to cpu i. Always at
+// least 1, the engines use it as the upper bound of a clamp.
+[[nodiscard]] inline std::size_t pool_thread_count() {
+  // hardware_concurrency() is 0 when it can't tell
+  return positive_env("GOL_THREADS")
+      .value_or(std::max<std::size_t>(1, std::thread::hardware_concurrency()));
+}
+
+[[nodiscard]] inline bool pool_pin_threads() {
+  const auto *pin = std::getenv("GOL_PIN_THREADS");
+  return pin != nullptr && std::string_view{pin} == "1";
+}
+
+inline void print_pool_stats(const WorkStealingPool &pool) {
+  const auto stats = pool.stats();
+
+  std::chrono::duration<double, std::milli> total_busy{};
+  std::chrono::duration<double, std::milli> max_busy{};
+  for (const auto &thread : stats) {
+    total_busy += thread.busy;
+    max_busy = std::max<std::chrono::duration<double, std::milli>>(
+        max_busy, thread.busy);
+  }
+
+  for (std::size_t index = 0; index < stats.size(); ++index) {
+    std::cout << "  Thread " << index << ": " << stats[index].tasks
+              << " tasks (" << stats[index].steals << " stolen) "
+              << std::chrono::duration<double, std::milli>(stats[index].busy)
+              << " busy\n";
+  }
+
+  // 1.0 is perfectly balanced, the slowest thread is what we wait on
+  const auto mean_busy = total_busy / static_cast<double>(stats.size());
+  std::cout << "  Load imbalance (max / mean busy): "
+            << (mean_busy.count() > 0 ? max_busy / mean_busy : 1.0) << '\n';
+}
+
+// Tiled, but scheduled on our own work-stealing pool instead of
+// std::execution::par_unseq
+template <std::size_t Width, std::size_t Height> struct ThreadPoolEngine {
+  using board_type = GameBoard<Width, Height>;
+  static constexpr std::string_view name = "thread_pool";
+
+  WorkStealingPool pool{pool_thread_count(), pool_pin_threads()};
+
+  // a few bands per thread, so there is something left to steal, but not
+  // so small that waking the pool costs more than the band itself
+  static constexpr std::size_t min_band_cells = 16 * 1024;
+  std::size_t band_count = std::clamp<std::size_t>(
+      std::min(Width * Height / min_band_cells, pool.thread_count() * 8), 1,
+      Height);
+  std::size_t band_height = (Height + band_count - 1) / band_count;
+
+  void step(const board_type &input, board_type &output) {
+    if (band_count == 1) {
+      iterate_rows(input, output, 0, Height);
+      return;
+    }
+
+    pool.parallel_for(band_count, [&](std::size_t band) {
+      const auto first_row = band * band_height;
+      iterate_rows(input, output, std::min(first_row, Height),
+                   std::min(first_row + band_height, Height));
+    });
+  }
+
+  void report() const { print_pool_stats(pool); }
+};
+
+// The same threads for the whole run, each one always stepping the same
+// band of rows, meeting at a spinning barrier once per generation. No
+// fork/join per generation, so tiny boards with millions of iterations
+// don't pay more for synchronization than for the work.
+template <std::size_t Width, std::size_t Height> struct PersistentEngine {
+  using board_type = GameBoard<Width, Height>;
+  static constexpr std::string_view name = "persistent";
+
+  // much smaller than for the pool, a barrier is cheap compared to
+  // handing out tasks, but not free
+  static constexpr std::size_t min_band_cells = 4 * 1024;
+
+  WorkerTeam team{std::clamp<std::size_t>(
+                      std::min(Width * Height / min_band_cells, Height), 1,
+                      pool_thread_count()),
+                  pool_pin_threads()};
+
+  void step(const board_type &input, board_type &output) {
+    team.run([&](std::size_t member) {
+      iterate_rows(input, output, member * Height / team.size(),
+                   (member + 1) * Height / team.size());
+    });
+  }
+};
+
+// Persistent, plus the boards are allocated so that every page is first
+// touched (and so placed on the NUMA node of) the pinned thread that is going
+// to step it for the whole run. The default make_unique zeroes the entire
+// board from the main thread, putting all of it on the main thread's socket.
+template <std::size_t Width, std::size_t Height> struct NumaEngine {
+  using board_type = GameBoard<Width, Height>;
+  static constexpr std::string_view name = "numa";
+
+  static constexpr std::size_t min_band_cells = 4 * 1024;
+
+  // member 0 of the team is whoever calls run(), so the thread that owns the
+  // engine is pinned to cpu 0 for as long as the engine lives, like worker i
+  // is to cpu i (declared before the team, so it is restored after the team
+  // is gone)
+  ScopedCpuPin pin{0};
+
+  // pinned no matter what GOL_PIN_THREADS says, if the OS moves a thread to
+  // the other socket its band stays behind
+  WorkerTeam team{std::clamp<std::size_t>(
+                      std::min(Width * Height / min_band_cells, Height), 1,
+                      pool_thread_count()),
+                  true};
+
+  template <typename Board>
+  [[nodiscard]] auto band(Board &board, std::size_t member) const {
+    const auto first_row = member * Height / team.size();
+    const auto last_row = (member + 1) * Height / team.size();
+    return std::span(board.data).subspan(first_row * Width,
+                                         (last_row - first_row) * Width);
+  }
+
+  // the boards we handed out, so report() can check where they ended up
+  std::vector<const board_type *> boards;
+
+  [[nodiscard]] std::unique_ptr<board_type> make_board() {
+    // uninitialized, so nothing has been touched yet
+    auto board = std::make_unique_for_overwrite<board_type>();
+    team.run([&](std::size_t member) {
+      std::ranges::fill(band(*board, member), false);
+    });
+    boards.push_back(board.get());
+    return board;
+  }
+
+  void step(const board_type &input, board_type &output) {
+    team.run([&](std::size_t member) {
+      iterate_rows(input, output, member * Height / team.size(),
+                   (member + 1) * Height / team.size());
+    });
+  }
+
+  void report() {
+    std::vector<PagePlacement> placements(team.size());
+    team.run([&](std::size_t member) {
+      const auto node = current_numa_node();
+      for (auto *board : boards) {
+        const auto cells = band(*board, member);
+        // the first band also owns the page the board starts in, every
+        // other page belongs to the band it starts in
+        const void *first =
+            member == 0 ? page_floor(cells.data()) : cells.data();
+        placements[member] +=
+            page_placement(first, cells.data() + cells.size(), node);
+      }
+    });
+
+    PagePlacement total;
+    for (const auto &placement : placements) {
+      total += placement;
+    }
+    std::cout << "  Pages on a remote NUMA node: " << total.remote << " of "
+              << total.local + total.remote << " (remote page ratio "
+              << total.remote_page_ratio() << "), " << total.unknown
+              << " unknown\n";
+  }
+};
+
+// Tiled, for any life-like rule
+template <std::size_t Width, std::size_t Height> struct RuleEngine {
+  using board_type = GameBoard<Width, Height>;
+  static constexpr std::string_view name = "rules";
+
+  LifeRule rule = selected_rule();
+  rule_stepper<board_type> stepper = select_rule_stepper<board_type>(rule);
+
+  void step(const board_type &input, board_type &output) {
+    stepper(input, output, rule);
+  }
+
+  void report() const {
+    std::cout << "  Rule: " << to_string(rule)
+              << (is_known_rule(rule) ? " (compiled in)" : " (runtime table)")
+              << '\n';
+  }
+};
+
+// Tiles are kept in cache for several generations before they are written
+// back, instead of one trip through memory per generation.
+// GOL_TEMPORAL_GENERATIONS=<k> picks how many at runtime. The scratch
+// buffers are sized at build time for -DGOL_TEMPORAL_GENERATIONS=<max>
+// (default 8), larger k are cut down to that.
+template <std::size_t Width, std::size_t Height> struct TemporalEngine {
+  using board_type = GameBoard<Width, Height>;
+  static constexpr std::string_view name = "temporal";
+
+  static constexpr std::size_t max_generations_per_pass =
+      GOL_TEMPORAL_GENERATIONS;
+
+  std::size_t generations_per_pass =
+      std::min(positive_env("GOL_TEMPORAL_GENERATIONS")
+                   .value_or(max_generations_per_pass),
+               max_generations_per_pass);
+
+  std::size_t step(const board_type &input, board_type &output,
+                   std::size_t max_generations) {
+    return iterate_board_temporal(
+        input, output, std::min(max_generations, generations_per_pass));
+  }
+
+  void report() const {
+    std::cout << "  Generations per pass: " << generations_per_pass
+              << " (at most " << max_generations_per_pass << ")\n";
+  }
+};
+
+// Memoized quadtree, the whole run is done as a handful of 2^n generation
+// jumps, which is nearly free for sparse or repeating patterns
+template <std::size_t Width, std::size_t Height> struct HashLifeEngine {
+  using board_type = GameBoard<Width, Height>;
+  static constexpr std::string_view name = "hashlife";
+
+  HashLife<Width, Height> hashlife;
+
+  std::size_t step(const board_type &input, board_type &output,
+                   std::size_t max_generations) {
+    hashlife.load(input);
+    hashlife.advance(max_generations);
+    hashlife.store(output);
+    return max_generations;
+  }
+};
+
+// Engines that care about where the memory ends up allocate it themselves
+template <typename Engine> [[nodiscard]] auto make_board(Engine &engine) {
+  if constexpr (requires { engine.make_board(); }) {
+    return engine.make_board();
+  } else {
+    return std::make_unique<typename Engine::board_type>();
+  }
+}
+
+// Advances `generations` generations, just swapping buffers back and forth,
+// so the result always ends up in board1
+template <typename Engine, typename BoardType>
+void step_generations(Engine &engine, std::unique_ptr<BoardType> &board1,
+                      std::unique_ptr<BoardType> &board2,
+                      std::size_t generations) {
+  for (std::size_t i = 0; i < generations;) {
+    // engines that can do several generations at once tell us how many
+    // they did, everything else is one generation per step
+    if constexpr (requires { engine.step(*board1, *board2, generations); }) {
+      i += engine.step(*board1, *board2, generations - i);
+    } else {
+      engine.step(*board1, *board2);
+      ++i;
+    }
+    std::swap(board1, board2);
+  }
+}
+
+// The same, but stops every `every` generations (and before the first and
+// after the last, even when `every` does not divide `generations`) to hand
+// the board to on_frame(generation, board), ie to record it
+template <typename Engine, typename BoardType, typename OnFrame>
+void step_generations(Engine &engine, std::unique_ptr<BoardType> &board1,
+                      std::unique_ptr<BoardType> &board2,
+                      std::size_t generations, std::size_t every,
+                      OnFrame &&on_frame) {
+  every = std::max<std::size_t>(every, 1);
+  on_frame(std::uint64_t{0}, std::as_const(*board1));
+  for (std::size_t done = 0; done < generations;) {
+    const auto count = std::min(every - done % every, generations - done);
+    step_generations(engine, board1, board2, count);
+    done += count;
+    if (done % every == 0 || done == generations) {
+      on_frame(std::uint64_t{done}, std::as_const(*board1));
+    }
+  }
+}
+
+#endif
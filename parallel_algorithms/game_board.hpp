@@ -0,0 +1,159 @@
+#ifndef CPP_WEEKLY_GAME_BOARD_HPP
+#define CPP_WEEKLY_GAME_BOARD_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <execution>
+#include <limits>
+#include <memory>
+
+// Handy modulo operator that wraps around automatically
+[[nodiscard]] constexpr auto floor_modulo(auto dividend, auto divisor) {
+  return ((dividend % divisor) + divisor) % divisor;
+}
+
+// This is probably unnecessary, but the min_int
+// utilities exist to make the `Point` type as compact as possible
+// so that we only use int16 if that's all we need, for example
+template <std::size_t value> auto min_int() {
+  if constexpr (value <= std::numeric_limits<std::int8_t>::max()) {
+    return std::int8_t{};
+  } else if constexpr (value <= std::numeric_limits<std::int16_t>::max()) {
+    return std::int16_t{};
+  } else if constexpr (value <= std::numeric_limits<std::int32_t>::max()) {
+    return std::int32_t{};
+  } else {
+    return std::int64_t{};
+  }
+}
+
+template <std::size_t value> using min_int_t = decltype(min_int<value>());
+
+// templated on size mostly to give the compiler extra hints
+// about the code, so it knows what it can unroll, etc.
+template <std::size_t Width, std::size_t Height> struct GameBoard {
+  // These are the properly sized things necessary to hold coordinates
+  // that work with this particular size of board
+  using x_index_t = min_int_t<Width>;
+  using y_index_t = min_int_t<Height>;
+
+  static constexpr x_index_t width = Width;
+  static constexpr y_index_t height = Height;
+
+  std::array<bool, Width * Height> data;
+
+  struct Point {
+    x_index_t x;
+    y_index_t y;
+    [[nodiscard]] constexpr Point operator+(Point rhs) const {
+      return Point{static_cast<x_index_t>(x + rhs.x),
+                   static_cast<y_index_t>(y + rhs.y)};
+    }
+  };
+
+  // The 8 relative positions for neighbors for a given point
+  constexpr static std::array<Point, 8> neighbors{
+      Point{-1, -1}, Point{0, -1}, Point{1, -1}, Point{-1, 0},
+      Point{1, 0},   Point{-1, 1}, Point{0, 1},  Point{1, 1}};
+
+  // Takes the input point, wraps it vertically/horizontally and takes
+  // the new location and maps that to the linear address of the point
+  // in the underlying array
+  [[nodiscard]] constexpr static std::size_t index(Point p) {
+    return static_cast<std::size_t>(floor_modulo(p.y, height) * width +
+                                    floor_modulo(p.x, width));
+  }
+
+  [[nodiscard]] constexpr bool operator[](Point p) const noexcept {
+    return data[index(p)];
+  }
+
+  constexpr void set(Point p) noexcept { data[index(p)] = true; }
+
+  [[nodiscard]] constexpr std::size_t count_neighbors(Point p) const {
+    return static_cast<std::size_t>(
+        std::count_if(neighbors.begin(), neighbors.end(),
+                      [&](auto offset) { return (*this)[p + offset]; }));
+  }
+
+  // Pre-compute all of the Point coordinates that exist in this particular
+  // gameboard. We use this later to iterate over every location in the
+  // gameboard.
+  [[nodiscard]] static auto make_indexes() {
+    auto result = std::make_unique<std::array<Point, Width * Height>>();
+
+    std::size_t output_index = 0;
+
+    for (y_index_t y = 0; y < height; ++y) {
+      for (x_index_t x = 0; x < width; ++x) {
+        (*result)[output_index] = Point{x, y};
+        ++output_index;
+      }
+    }
+    return result;
+  };
+
+  // https://en.wikipedia.org/wiki/Conway's_Game_of_Life#Examples_of_patterns
+
+  // Add a glider at a given location on the game board
+  constexpr void add_glider(Point p) {
+    set(p);
+    set(p + Point{1, 1});
+    set(p + Point{2, 1});
+    set(p + Point{0, 2});
+    set(p + Point{1, 2});
+  }
+};
+
+// A Point of any of the board types, from plain coordinates
+template <typename BoardType>
+[[nodiscard]] constexpr auto make_point(std::size_t x, std::size_t y) {
+  using point_type = typename BoardType::Point;
+  return point_type{static_cast<decltype(point_type::x)>(x),
+                    static_cast<decltype(point_type::y)>(y)};
+}
+
+template <typename BoardType>
+constexpr void iterate_board(const BoardType &input, BoardType &output,
+                             auto &indices) {
+
+  const auto rules = [&](const auto &index) {
+    const auto neighbor_count = input.count_neighbors(index);
+    const auto is_alive = input[index];
+
+    if (is_alive) {
+      if (neighbor_count < 2) {
+        return false;
+      } else if (neighbor_count <= 3) {
+        return true;
+      } else {
+        return false;
+      }
+    } else {
+      if (neighbor_count == 3) {
+        return true;
+      } else {
+        return false;
+      }
+    }
+
+    return true;
+  };
+
+#ifndef SERIAL
+  if consteval {
+#endif
+    std::transform(indices.begin(), indices.end(), output.data.begin(), rules);
+#ifndef SERIAL
+  } else {
+    // std::execution::par_unseq to tell the runtime that it can parallelize
+    // this
+    std::transform(std::execution::par_unseq, indices.begin(), indices.end(),
+                   output.data.begin(), rules);
+  }
+#endif
+}
+
+#endif
@@ -1,12 +1,27 @@
 #include <algorithm>
-#include <array>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
-#include <execution>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
-#include <limits>
 #include <memory>
 #include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "engines.hpp"
+#include "game_board.hpp"
+#include "perf_counters.hpp"
+#include "recorder.hpp"
+#include "snapshot.hpp"
+#include "warm_start.hpp"
 
 // This is a simple conway's game-of-life implementation
 // that is constexpr friendly and can work as a benchmark
@@ -73,145 +88,44 @@
 //
 // Run, watch nvtop, htop, run with /usr/bin/time to see total CPU utilization,
 // etc and see how it scales on your platform
-
-// Handy modulo operator that wraps around automatically
-[[nodiscard]] constexpr auto floor_modulo(auto dividend, auto divisor) {
-  return ((dividend % divisor) + divisor) % divisor;
-}
-
-// This is probably unnecessary, but the min_int
-// utilities exist to make the `Point` type as compact as possible
-// so that we only use int16 if that's all we need, for example
-template <std::size_t value> auto min_int() {
-  if constexpr (value <= std::numeric_limits<std::int8_t>::max()) {
-    return std::int8_t{};
-  } else if constexpr (value <= std::numeric_limits<std::int16_t>::max()) {
-    return std::int16_t{};
-  } else if constexpr (value <= std::numeric_limits<std::int32_t>::max()) {
-    return std::int32_t{};
-  } else {
-    return std::int64_t{};
-  }
-}
-
-template <std::size_t value> using min_int_t = decltype(min_int<value>());
-
-// templated on size mostly to give the compiler extra hints
-// about the code, so it knows what it can unroll, etc.
-template <std::size_t Width, std::size_t Height> struct GameBoard {
-  // These are the properly sized things necessary to hold coordinates
-  // that work with this particular size of board
-  using x_index_t = min_int_t<Width>;
-  using y_index_t = min_int_t<Height>;
-
-  static constexpr x_index_t width = Width;
-  static constexpr y_index_t height = Height;
-
-  std::array<bool, Width * Height> data;
-
-  struct Point {
-    x_index_t x;
-    y_index_t y;
-    [[nodiscard]] constexpr Point operator+(Point rhs) const {
-      return Point{static_cast<x_index_t>(x + rhs.x),
-                   static_cast<y_index_t>(y + rhs.y)};
-    }
-  };
-
-  // The 8 relative positions for neighbors for a given point
-  constexpr static std::array<Point, 8> neighbors{
-      Point{-1, -1}, Point{0, -1}, Point{1, -1}, Point{-1, 0},
-      Point{1, 0},   Point{-1, 1}, Point{0, 1},  Point{1, 1}};
-
-  // Takes the input point, wraps it vertically/horizontally and takes
-  // the new location and maps that to the linear address of the point
-  // in the underlying array
-  [[nodiscard]] constexpr static std::size_t index(Point p) {
-    return static_cast<std::size_t>(floor_modulo(p.y, height) * width +
-                                    floor_modulo(p.x, width));
-  }
-
-  [[nodiscard]] constexpr bool operator[](Point p) const noexcept {
-    return data[index(p)];
-  }
-
-  constexpr void set(Point p) noexcept { data[index(p)] = true; }
-
-  [[nodiscard]] constexpr std::size_t count_neighbors(Point p) const {
-    return static_cast<std::size_t>(
-        std::count_if(neighbors.begin(), neighbors.end(),
-                      [&](auto offset) { return (*this)[p + offset]; }));
-  }
-
-  // Pre-compute all of the Point coordinates that exist in this particular
-  // gameboard. We use this later to iterate over every location in the
-  // gameboard.
-  [[nodiscard]] static auto make_indexes() {
-    auto result = std::make_unique<std::array<Point, Width * Height>>();
-
-    std::size_t output_index = 0;
-
-    for (y_index_t y = 0; y < height; ++y) {
-      for (x_index_t x = 0; x < width; ++x) {
-        (*result)[output_index] = Point{x, y};
-        ++output_index;
-      }
-    }
-    return result;
-  };
-
-  // https://en.wikipedia.org/wiki/Conway's_Game_of_Life#Examples_of_patterns
-
-  // Add a glider at a given location on the game board
-  constexpr void add_glider(Point p) {
-    set(p);
-    set(p + Point{1, 1});
-    set(p + Point{2, 1});
-    set(p + Point{0, 2});
-    set(p + Point{1, 2});
-  }
-};
-
-template <typename BoardType>
-constexpr void iterate_board(const BoardType &input, BoardType &output,
-                             auto &indices) {
-
-  const auto rules = [&](const auto &index) {
-    const auto neighbor_count = input.count_neighbors(index);
-    const auto is_alive = input[index];
-
-    if (is_alive) {
-      if (neighbor_count < 2) {
-        return false;
-      } else if (neighbor_count <= 3) {
-        return true;
-      } else {
-        return false;
-      }
-    } else {
-      if (neighbor_count == 3) {
-        return true;
-      } else {
-        return false;
-      }
-    }
-
-    return true;
-  };
-
-#ifndef SERIAL
-  if consteval {
-#endif
-    std::transform(indices.begin(), indices.end(), output.data.begin(), rules);
-#ifndef SERIAL
-  } else {
-    // std::execution::par_unseq to tell the runtime that it can parallelize
-    // this
-    std::transform(std::execution::par_unseq, indices.begin(), indices.end(),
-                   output.data.begin(), rules);
-  }
-#endif
-}
+//
+// By default every board size is run with the dense engine, which is what
+// run_performance_tests.sh has always measured. The other engines (see
+// DenseEngine and friends in engines.hpp) are picked by naming them on the
+// command line, or all of them with `all`:
+//
+// ```sh
+// ./a.out dense bit_packed
+// ./a.out all
+// ```
+//
+// The thread_pool, persistent and numa engines do not need TBB at all, see
+// pool_thread_count() for how to set their thread count and pinning.
+//
+// GOL_LOAD=<file> starts every board from a ".rle" pattern or a snapshot
+// instead of the two gliders, and GOL_SAVE=<prefix> writes each final board
+// to <prefix>-<engine>-<width>x<height>.gol (see snapshot.hpp). A file with
+// another rule than the engine's (Conway, or GOL_RULE for the rules and simd
+// engines) is an error.
+//
+// GOL_RECORD=<prefix> records every GOL_RECORD_EVERY=<n>th (default: every)
+// generation of each run to <prefix>-<engine>-<width>x<height>.golr, see
+// FrameRecorder and FrameReader in recorder.hpp.
+//
+// Building with -DGOL_CONSTEXPR_BUDGET=<cell updates> runs the first
+// generations of the smaller boards at compile time (see warm_start.hpp),
+// and only the rest of them are timed.
+//
+// Hardware counters (perf_counters.hpp) are read around every "Running
+// Board", and GOL_PERF_BANDS=<n> also splits each run into n bands of
+// generations with counters of their own. GOL_PERF_CSV=<file> writes the
+// total time (ms) and counters of all the runs as the "Time (ms)" and
+// "Cycles" ... "Branch Miss Ratio" columns of performance_stats.csv, which
+// is what run_performance_tests.sh uses.
+//
+// For repeated runs with statistics and JSON output, the same engines are
+// registered as Google Benchmarks in game_of_life_benchmarks.cpp, which is
+// built by CMake.
 
 struct Timer {
   std::string m_event;
@@ -247,13 +161,63 @@ template <typename BoardType> auto print_board(const BoardType &board) {
   }
 }
 
+// The pattern every run starts from, unless GOL_LOAD says otherwise
+inline constexpr auto add_gliders = [](auto &board) {
+  using point_type = typename std::remove_cvref_t<decltype(board)>::Point;
+  board.add_glider(point_type(1, 3));
+  board.add_glider(point_type(10, 1));
+};
+
+// add_gliders, already run as far as GOL_CONSTEXPR_BUDGET allows
 template <std::size_t Width, std::size_t Height, std::size_t Iterations>
-void run_board() {
-  using board_type = GameBoard<Width, Height>;
+inline constexpr auto warm_gliders =
+    warm_start<Width, Height, Iterations>(add_gliders);
+
+[[nodiscard]] std::size_t recording_interval() {
+  if (const auto *every = std::getenv("GOL_RECORD_EVERY")) {
+    return std::strtoul(every, nullptr, 10);
+  }
+  return 1;
+}
 
-  std::cout << "Running Time Test: " << Width << "x" << Height << " "
-            << Iterations << " iterations. " << Width * Height * Iterations
-            << " cell computations\n";
+[[nodiscard]] std::size_t perf_band_count() {
+  if (const auto *bands = std::getenv("GOL_PERF_BANDS")) {
+    return std::strtoul(bands, nullptr, 10);
+  }
+  return 1;
+}
+
+// Everything inside "Running Board", summed over all runs, for GOL_PERF_CSV
+struct RunningTotals {
+  std::chrono::duration<double, std::milli> time{};
+  PerfSample counters = [] {
+    PerfSample zero;
+    zero.counts.fill(0.0);
+    return zero;
+  }();
+};
+
+[[nodiscard]] RunningTotals &running_totals() {
+  static RunningTotals totals;
+  return totals;
+}
+
+template <template <std::size_t, std::size_t> typename Engine,
+          std::size_t Width, std::size_t Height, std::size_t Iterations>
+void run_board() {
+  using engine_type = Engine<Width, Height>;
+  using board_type = typename engine_type::board_type;
+
+  std::cout << "Running Time Test: [" << engine_type::name << "] " << Width
+            << "x" << Height << " " << Iterations << " iterations. "
+            << Width * Height * Iterations << " cell computations\n";
+
+  const auto output_path = [](std::string_view prefix,
+                              std::string_view extension) {
+    return std::string{prefix} + "-" + std::string{engine_type::name} + "-" +
+           std::to_string(Width) + "x" + std::to_string(Height) +
+           std::string{extension};
+  };
 
   // I would consider putting these on the stack, but the GPU engine
   // requires pointers that it knows how to work with. With AdaptiveCpp
@@ -261,25 +225,116 @@ void run_board() {
   // with the GPU automagically
 
   std::optional<Timer> timer{"Setup"};
-  auto board1 = std::make_unique<board_type>();
-  board1->add_glider(typename board_type::Point(1, 3));
-  board1->add_glider(typename board_type::Point(10, 1));
-  auto board2 = std::make_unique<board_type>();
+  auto engine = std::make_unique<engine_type>();
 
-  const auto indices = board_type::make_indexes();
+  // only the rules and simd engines run anything but Conway
+  constexpr bool follows_gol_rule = requires { engine->rule; };
+  const LifeRule rule = [&] {
+    if constexpr (follows_gol_rule) {
+      return engine->rule;
+    } else {
+      return conway_rule;
+    }
+  }();
+
+  auto board1 = make_board(*engine);
+  std::size_t warm_generations = 0;
+  if (const auto *path = std::getenv("GOL_LOAD")) {
+    const auto info = load_board(path, *board1);
+    if (info.rule != rule) {
+      throw std::runtime_error(std::string{path} + " is a " +
+                               to_string(info.rule) + " pattern, but the " +
+                               std::string{engine_type::name} +
+                               " engine runs " + to_string(rule) +
+                               (follows_gol_rule ? " (see GOL_RULE)" : ""));
+    }
+  } else {
+    add_gliders(*board1);
+
+    // only instantiated if it does anything, the board is embedded in the
+    // binary
+    if constexpr (warm_start_generations<Width, Height, Iterations> > 0) {
+      if (rule == conway_rule) {
+        const auto &warm = warm_gliders<Width, Height, Iterations>;
+        load_warm_start(*board1, warm.board);
+        warm_generations = warm.generations;
+      }
+    }
+  }
+  auto board2 = make_board(*engine);
+  const auto generations = Iterations - warm_generations;
+
+  std::optional<FrameRecorder> recorder;
+  if (const auto *prefix = std::getenv("GOL_RECORD")) {
+    recorder.emplace(output_path(prefix, ".golr"), Width, Height);
+  }
   timer.reset(); // show how long setup took
 
+  if (warm_generations > 0) {
+    std::cout << "Warm Start: " << warm_generations
+              << " iterations done at compile time\n";
+  }
+
   {
+    // the first and last generation of a band, and its counters
+    std::vector<std::pair<std::pair<std::uint64_t, std::uint64_t>, PerfSample>>
+        bands;
+
     Timer timer2{"Running Board"};
-    for (int i = 0; i < Iterations; ++i) {
-      // just swapping buffers back and forth
-      iterate_board(*board1, *board2, *indices);
-      std::swap(board1, board2);
+    const auto counters_before = perf_counters().read();
+    if (recorder) {
+      step_generations(*engine, board1, board2, generations,
+                       recording_interval(),
+                       [&](std::uint64_t generation, const board_type &board) {
+                         recorder->record(warm_generations + generation, board);
+                       });
+    } else if (const auto band_count = perf_band_count(); band_count > 1) {
+      auto band_start = std::pair{std::uint64_t{0}, counters_before};
+      step_generations(
+          *engine, board1, board2, generations,
+          (generations + band_count - 1) / band_count,
+          [&](std::uint64_t generation, const board_type &) {
+            if (generation > 0) {
+              const auto now = perf_counters().read();
+              bands.emplace_back(std::pair{band_start.first, generation},
+                                 now - band_start.second);
+              band_start = {generation, now};
+            }
+          });
+    } else {
+      step_generations(*engine, board1, board2, generations);
     }
+    const auto counters = perf_counters().read() - counters_before;
+    const auto seconds = timer2.seconds();
+
+    running_totals().time += seconds;
+    running_totals().counters += counters;
+
     std::cout << "Cells Per Second: "
-              << static_cast<double>(Width * Height * Iterations) /
-                     timer2.seconds().count()
+              << static_cast<double>(Width * Height * generations) /
+                     seconds.count()
               << '\n';
+
+    if (perf_counters().available()) {
+      std::cout << perf_summary(counters) << '\n';
+      for (const auto &[range, band] : bands) {
+        std::cout << "  Generations " << warm_generations + range.first
+                  << " - " << warm_generations + range.second << ": "
+                  << perf_summary(band) << '\n';
+      }
+    }
+
+    // engines with their own scheduler can say how the work was spread out
+    if constexpr (requires { engine->report(); }) {
+      engine->report();
+    }
+    if (recorder) {
+      std::cout << "Recorder stalls: " << recorder->stalls() << '\n';
+    }
+  }
+
+  if (const auto *prefix = std::getenv("GOL_SAVE")) {
+    save_board(output_path(prefix, ".gol"), *board1, rule, Iterations);
   }
 
   if (Width <= 100 && Height <= 30) {
@@ -295,12 +350,51 @@ void run_board() {
   }
 }
 
-int main() {
-  run_board<10, 10, 5'000'000>();
-  run_board<100, 10, 500'000>();
-  run_board<100, 100, 50'000>();
-  run_board<100, 1000, 5'000>();
-  run_board<1000, 1000, 500>();
-  run_board<10000, 1000, 50>();
-  run_board<10000, 10000, 5>();
+// Engine names (or "all") can be passed on the command line to run those,
+// by default only the dense engine is run
+template <template <std::size_t, std::size_t> typename Engine>
+void run_boards(std::span<const char *const> selected_engines) {
+  const auto is_selected = [&](std::string_view name) {
+    return std::ranges::find(selected_engines, name) != selected_engines.end();
+  };
+  if (selected_engines.empty() ? Engine<1, 1>::name != DenseEngine<1, 1>::name
+                               : !is_selected(Engine<1, 1>::name) &&
+                                     !is_selected("all")) {
+    return;
+  }
+
+  run_board<Engine, 10, 10, 5'000'000>();
+  run_board<Engine, 100, 10, 500'000>();
+  run_board<Engine, 100, 100, 50'000>();
+  run_board<Engine, 100, 1000, 5'000>();
+  run_board<Engine, 1000, 1000, 500>();
+  run_board<Engine, 10000, 1000, 50>();
+  run_board<Engine, 10000, 10000, 5>();
+}
+
+int main(int argc, const char *argv[]) {
+  const std::span<const char *const> selected_engines(
+      argv + 1, static_cast<std::size_t>(argc - 1));
+
+  // before any worker threads exist, so the counters follow all of them
+  [[maybe_unused]] const auto &counters = perf_counters();
+
+  run_boards<DenseEngine>(selected_engines);
+  run_boards<TiledEngine>(selected_engines);
+  run_boards<LookupEngine>(selected_engines);
+  run_boards<SimdEngine>(selected_engines);
+  run_boards<RuleEngine>(selected_engines);
+  run_boards<ThreadPoolEngine>(selected_engines);
+  run_boards<PersistentEngine>(selected_engines);
+  run_boards<NumaEngine>(selected_engines);
+  run_boards<TemporalEngine>(selected_engines);
+  run_boards<ActiveEngine>(selected_engines);
+  run_boards<BitPackedEngine>(selected_engines);
+  run_boards<HashLifeEngine>(selected_engines);
+
+  if (const auto *path = std::getenv("GOL_PERF_CSV")) {
+    std::ofstream csv(path);
+    csv << std::llround(running_totals().time.count()) << ','
+        << perf_csv_fields(running_totals().counters) << '\n';
+  }
 }
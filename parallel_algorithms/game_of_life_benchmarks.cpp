@@ -0,0 +1,83 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "engines.hpp"
+#include "game_board.hpp"
+
+// Every engine from game_of_life.cpp at every board size, as Google
+// Benchmarks, so they can be compared with repetitions, statistics and
+// JSON output, for example:
+//
+// ```sh
+// ./game_of_life_benchmarks --benchmark_filter='<(Tiled|Simd)Engine'
+//     --benchmark_repetitions=10 --benchmark_format=json
+// ```
+//
+// Each benchmark iteration advances state.range(0) generations, so engines
+// that can do several generations per pass (temporal, hashlife) get the
+// chance to.
+
+template <template <std::size_t, std::size_t> typename Engine,
+          std::size_t Width, std::size_t Height>
+static void GameOfLife(benchmark::State &state) {
+  using engine_type = Engine<Width, Height>;
+  using board_type = typename engine_type::board_type;
+
+  auto engine = std::make_unique<engine_type>();
+  auto board1 = make_board(*engine);
+  board1->add_glider(typename board_type::Point(1, 3));
+  board1->add_glider(typename board_type::Point(10, 1));
+  auto board2 = make_board(*engine);
+
+  const auto generations = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    step_generations(*engine, board1, board2, generations);
+    benchmark::DoNotOptimize(board1->data.data());
+    benchmark::ClobberMemory();
+  }
+
+  const auto cells = static_cast<double>(Width * Height * generations) *
+                     static_cast<double>(state.iterations());
+  state.counters["cells_per_second"] =
+      benchmark::Counter(cells, benchmark::Counter::kIsRate);
+
+  // the storage of one board read and one written per generation
+  state.SetBytesProcessed(
+      static_cast<std::int64_t>(2 * sizeof(board_type::data) * generations) *
+      state.iterations());
+}
+
+static void engine_options(benchmark::internal::Benchmark *benchmark) {
+  // real time, the multithreaded engines do most of their work on other
+  // threads
+  benchmark->ArgName("generations")->Arg(16)->UseRealTime();
+}
+
+// The same sizes (and so the same cells per run) as run_boards
+#define GOL_BENCHMARK_ENGINE(Engine)                                           \
+  BENCHMARK_TEMPLATE(GameOfLife, Engine, 10, 10)->Apply(engine_options);       \
+  BENCHMARK_TEMPLATE(GameOfLife, Engine, 100, 10)->Apply(engine_options);      \
+  BENCHMARK_TEMPLATE(GameOfLife, Engine, 100, 100)->Apply(engine_options);     \
+  BENCHMARK_TEMPLATE(GameOfLife, Engine, 100, 1000)->Apply(engine_options);    \
+  BENCHMARK_TEMPLATE(GameOfLife, Engine, 1000, 1000)->Apply(engine_options);   \
+  BENCHMARK_TEMPLATE(GameOfLife, Engine, 10000, 1000)->Apply(engine_options);  \
+  BENCHMARK_TEMPLATE(GameOfLife, Engine, 10000, 10000)->Apply(engine_options)
+
+GOL_BENCHMARK_ENGINE(DenseEngine);
+GOL_BENCHMARK_ENGINE(TiledEngine);
+GOL_BENCHMARK_ENGINE(LookupEngine);
+GOL_BENCHMARK_ENGINE(SimdEngine);
+GOL_BENCHMARK_ENGINE(RuleEngine);
+GOL_BENCHMARK_ENGINE(ThreadPoolEngine);
+GOL_BENCHMARK_ENGINE(PersistentEngine);
+GOL_BENCHMARK_ENGINE(NumaEngine);
+GOL_BENCHMARK_ENGINE(TemporalEngine);
+GOL_BENCHMARK_ENGINE(ActiveEngine);
+GOL_BENCHMARK_ENGINE(BitPackedEngine);
+GOL_BENCHMARK_ENGINE(HashLifeEngine);
+
+BENCHMARK_MAIN();
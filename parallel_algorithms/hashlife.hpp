@@ -0,0 +1,435 @@
+#ifndef CPP_WEEKLY_HASHLIFE_HPP
+#define CPP_WEEKLY_HASHLIFE_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "game_board.hpp"
+
+// Hashlife: https://en.wikipedia.org/wiki/Hashlife
+//
+// The board is stored as a quadtree where every distinct node exists
+// exactly once (hash consing), and the result of advancing a node is
+// memoized. Empty space and repeating patterns then cost (almost) nothing,
+// and a single call can jump 2^n generations.
+//
+// Hashlife is normally defined on an infinite plane, but our boards wrap
+// around. A WxH torus is exactly the infinite plane tiled with copies of
+// the board, so for each jump we build the quadtree of that tiled plane
+// (which hash conses down to a handful of distinct nodes per level, because
+// the copies repeat) and crop one board back out of the result.
+template <std::size_t Width, std::size_t Height> class HashLife {
+public:
+  using node_id = std::uint32_t;
+
+  static constexpr std::size_t width = Width;
+  static constexpr std::size_t height = Height;
+
+  HashLife() { reset(); }
+
+  // Copy in any board that can be indexed with a Point (ie GameBoard)
+  template <typename BoardType> void load(const BoardType &board) {
+    reset();
+    m_torus = build(torus_level, 0, 0, [&](std::size_t x, std::size_t y) {
+      return static_cast<bool>(board[make_point<BoardType>(x, y)]);
+    });
+  }
+
+  // Write the current state into any board with data and set(Point)
+  template <typename BoardType> void store(BoardType &board) const {
+    board.data = {};
+    for_each_alive([&](std::size_t x, std::size_t y) {
+      board.set(make_point<BoardType>(x, y));
+    });
+  }
+
+  // Any number of generations, done as one power of 2 jump per set bit
+  void advance(std::uint64_t generations) {
+    while (generations > 0) {
+      const auto jump =
+          static_cast<std::size_t>(std::countr_zero(std::bit_floor(generations)));
+      advance_pow2(jump);
+      generations -= std::uint64_t{1} << jump;
+    }
+  }
+
+  [[nodiscard]] std::size_t node_count() const { return m_nodes.size(); }
+
+private:
+  // the smallest quadtree level that can hold the whole board
+  static constexpr std::size_t torus_level = static_cast<std::size_t>(
+      std::countr_zero(std::bit_ceil(std::max(Width, Height))));
+
+  // memoization tables are thrown away and rebuilt when they get this big
+  static constexpr std::size_t max_nodes = std::size_t{1} << 22;
+
+  static constexpr node_id dead_leaf = 0;
+  static constexpr node_id alive_leaf = 1;
+
+  enum Quadrant { nw, ne, sw, se };
+
+  struct Node {
+    std::array<node_id, 4> children;
+    std::size_t level;
+  };
+
+  struct ChildrenHash {
+    std::size_t operator()(const std::array<node_id, 4> &children) const {
+      std::uint64_t result = 0;
+      for (const auto child : children) {
+        result = (result ^ child) * 0x9E3779B97F4A7C15ULL;
+        result ^= result >> 29;
+      }
+      return std::hash<std::uint64_t>{}(result);
+    }
+  };
+
+  std::vector<Node> m_nodes;
+  std::unordered_map<std::array<node_id, 4>, node_id, ChildrenHash>
+      m_node_lookup;
+  std::vector<node_id> m_empty;
+
+  // (node, log2 of generations) -> center of the node that many gens later
+  std::unordered_map<std::uint64_t, node_id> m_successors;
+
+  // (level, x, y) -> node of the tiled plane, only valid for one jump
+  std::unordered_map<std::uint64_t, node_id> m_windows;
+
+  node_id m_torus = dead_leaf;
+
+  void reset() {
+    m_nodes.clear();
+    m_node_lookup.clear();
+    m_successors.clear();
+    m_windows.clear();
+    m_empty.clear();
+
+    // leaf 0 is a dead cell, leaf 1 is a live cell
+    m_nodes.push_back(Node{{}, 0});
+    m_nodes.push_back(Node{{}, 0});
+    m_empty.push_back(dead_leaf);
+  }
+
+  [[nodiscard]] const Node &node(node_id id) const { return m_nodes[id]; }
+
+  [[nodiscard]] node_id child(node_id id, Quadrant quadrant) const {
+    return m_nodes[id].children[quadrant];
+  }
+
+  [[nodiscard]] node_id empty(std::size_t level) {
+    while (m_empty.size() <= level) {
+      const auto smaller = m_empty.back();
+      m_empty.push_back(make_node({smaller, smaller, smaller, smaller}));
+    }
+    return m_empty[level];
+  }
+
+  [[nodiscard]] bool is_empty(node_id id) const {
+    const auto level = node(id).level;
+    return level < m_empty.size() && m_empty[level] == id;
+  }
+
+  [[nodiscard]] node_id make_node(const std::array<node_id, 4> &children) {
+    const auto [location, inserted] = m_node_lookup.try_emplace(
+        children, static_cast<node_id>(m_nodes.size()));
+    if (inserted) {
+      m_nodes.push_back(Node{children, node(children[0]).level + 1});
+    }
+    return location->second;
+  }
+
+  [[nodiscard]] node_id join(node_id nw_node, node_id ne_node,
+                             node_id sw_node, node_id se_node) {
+    const auto level = node(nw_node).level;
+    if (is_empty(nw_node) && is_empty(ne_node) && is_empty(sw_node) &&
+        is_empty(se_node)) {
+      return empty(level + 1);
+    }
+    return make_node({nw_node, ne_node, sw_node, se_node});
+  }
+
+  [[nodiscard]] static constexpr std::uint64_t size(std::size_t level) {
+    return std::uint64_t{1} << level;
+  }
+
+  // Builds the square of cells [x, x + 2^level) x [y, y + 2^level),
+  // anything outside of the board is dead
+  template <typename IsAlive>
+  [[nodiscard]] node_id build(std::size_t level, std::uint64_t x,
+                              std::uint64_t y, const IsAlive &is_alive) {
+    if (x >= Width || y >= Height) {
+      return empty(level);
+    }
+    if (level == 0) {
+      return is_alive(x, y) ? alive_leaf : dead_leaf;
+    }
+    const auto half = size(level - 1);
+    return join(build(level - 1, x, y, is_alive),
+                build(level - 1, x + half, y, is_alive),
+                build(level - 1, x, y + half, is_alive),
+                build(level - 1, x + half, y + half, is_alive));
+  }
+
+  // Walks down from `id` to the node of `target_level` containing (x, y)
+  [[nodiscard]] node_id descend(node_id id, std::size_t level,
+                                std::uint64_t x, std::uint64_t y,
+                                std::size_t target_level) const {
+    while (level > target_level) {
+      --level;
+      const auto half = size(level);
+      const auto east = x >= half;
+      const auto south = y >= half;
+      id = child(id, static_cast<Quadrant>(east + 2 * south));
+      x -= east * half;
+      y -= south * half;
+    }
+    return id;
+  }
+
+  template <typename Func>
+  void for_each_alive(node_id id, std::size_t level, std::uint64_t x,
+                      std::uint64_t y, const Func &func) const {
+    if (is_empty(id) || x >= Width || y >= Height) {
+      return;
+    }
+    if (level == 0) {
+      func(x, y);
+      return;
+    }
+    const auto half = size(level - 1);
+    for_each_alive(child(id, nw), level - 1, x, y, func);
+    for_each_alive(child(id, ne), level - 1, x + half, y, func);
+    for_each_alive(child(id, sw), level - 1, x, y + half, func);
+    for_each_alive(child(id, se), level - 1, x + half, y + half, func);
+  }
+
+  template <typename Func> void for_each_alive(const Func &func) const {
+    for_each_alive(m_torus, torus_level, 0, 0, func);
+  }
+
+  // Is anything alive in [x0, x1) x [y0, y1) of the node at (x, y)?
+  [[nodiscard]] bool any_alive(node_id id, std::size_t level, std::uint64_t x,
+                               std::uint64_t y, std::uint64_t x0,
+                               std::uint64_t x1, std::uint64_t y0,
+                               std::uint64_t y1) const {
+    const auto node_size = size(level);
+    if (is_empty(id) || x >= x1 || y >= y1 || x + node_size <= x0 ||
+        y + node_size <= y0) {
+      return false;
+    }
+    if (x >= x0 && x + node_size <= x1 && y >= y0 && y + node_size <= y1) {
+      return true;
+    }
+    const auto half = size(level - 1);
+    return any_alive(child(id, nw), level - 1, x, y, x0, x1, y0, y1) ||
+           any_alive(child(id, ne), level - 1, x + half, y, x0, x1, y0, y1) ||
+           any_alive(child(id, sw), level - 1, x, y + half, x0, x1, y0, y1) ||
+           any_alive(child(id, se), level - 1, x + half, y + half, x0, x1, y0,
+                     y1);
+  }
+
+  // The ranges of the board covered by [first, first + count), wrapped
+  [[nodiscard]] static auto wrapped_ranges(std::uint64_t first,
+                                           std::uint64_t count,
+                                           std::uint64_t extent) {
+    std::array<std::pair<std::uint64_t, std::uint64_t>, 2> result{};
+    if (count >= extent) {
+      result[0] = {0, extent};
+    } else if (first + count <= extent) {
+      result[0] = {first, first + count};
+    } else {
+      result[0] = {first, extent};
+      result[1] = {0, first + count - extent};
+    }
+    return result;
+  }
+
+  [[nodiscard]] bool window_empty(std::size_t level, std::uint64_t x,
+                                  std::uint64_t y) const {
+    for (const auto &[x0, x1] : wrapped_ranges(x, size(level), Width)) {
+      for (const auto &[y0, y1] : wrapped_ranges(y, size(level), Height)) {
+        if (x0 != x1 && y0 != y1 &&
+            any_alive(m_torus, torus_level, 0, 0, x0, x1, y0, y1)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  // The node for [x, x + 2^level) x [y, y + 2^level) of the infinite
+  // plane tiled with copies of the board. x and y are already wrapped.
+  [[nodiscard]] node_id tiled_window(std::size_t level, std::uint64_t x,
+                                     std::uint64_t y) {
+    const auto window_size = size(level);
+
+    // aligned and fully inside of the board: it already exists
+    if (x % window_size == 0 && y % window_size == 0 &&
+        x + window_size <= Width && y + window_size <= Height) {
+      return descend(m_torus, torus_level, x, y, level);
+    }
+
+    const auto key = ((x * Height + y) << 7) | level;
+    if (const auto found = m_windows.find(key); found != m_windows.end()) {
+      return found->second;
+    }
+
+    if (window_empty(level, x, y)) {
+      return empty(level);
+    }
+
+    const auto half = size(level - 1);
+    const auto east = (x + half % Width) % Width;
+    const auto south = (y + half % Height) % Height;
+    const auto result = join(
+        tiled_window(level - 1, x, y), tiled_window(level - 1, east, y),
+        tiled_window(level - 1, x, south), tiled_window(level - 1, east, south));
+    m_windows.emplace(key, result);
+    return result;
+  }
+
+  // Zeroes everything outside of the board (the neighboring copies)
+  [[nodiscard]] node_id crop(node_id id, std::size_t level, std::uint64_t x,
+                             std::uint64_t y) {
+    if (is_empty(id) || (x + size(level) <= Width && y + size(level) <= Height)) {
+      return id;
+    }
+    if (x >= Width || y >= Height) {
+      return empty(level);
+    }
+    const auto half = size(level - 1);
+    return join(crop(child(id, nw), level - 1, x, y),
+                crop(child(id, ne), level - 1, x + half, y),
+                crop(child(id, sw), level - 1, x, y + half),
+                crop(child(id, se), level - 1, x + half, y + half));
+  }
+
+  // One generation of the center 2x2 of a 4x4 node
+  [[nodiscard]] node_id life_4x4(node_id id) {
+    std::array<std::array<bool, 4>, 4> cells{};
+    for (std::size_t y = 0; y < 4; ++y) {
+      for (std::size_t x = 0; x < 4; ++x) {
+        cells[y][x] = descend(id, 2, x, y, 0) == alive_leaf;
+      }
+    }
+
+    const auto next = [&](std::size_t x, std::size_t y) {
+      unsigned neighbors = 0;
+      for (std::size_t ny = y - 1; ny <= y + 1; ++ny) {
+        for (std::size_t nx = x - 1; nx <= x + 1; ++nx) {
+          neighbors += cells[ny][nx];
+        }
+      }
+      neighbors -= cells[y][x];
+      return neighbors == 3 || (cells[y][x] && neighbors == 2) ? alive_leaf
+                                                               : dead_leaf;
+    };
+
+    return join(next(1, 1), next(2, 1), next(1, 2), next(2, 2));
+  }
+
+  // The center half of `id`, 2^jump generations later
+  // (jump <= level - 2, larger values are clamped)
+  [[nodiscard]] node_id successor(node_id id, std::size_t jump) {
+    const auto level = node(id).level;
+    if (is_empty(id)) {
+      return empty(level - 1);
+    }
+    if (level == 2) {
+      return life_4x4(id);
+    }
+    jump = std::min(jump, level - 2);
+
+    const auto key = (std::uint64_t{id} << 8) | jump;
+    if (const auto found = m_successors.find(key);
+        found != m_successors.end()) {
+      return found->second;
+    }
+
+    const auto q = [&](node_id parent, Quadrant outer, Quadrant inner) {
+      return child(child(parent, outer), inner);
+    };
+
+    // the 9 overlapping sub-squares, each advanced 2^(jump) or 2^(jump-1)
+    // generations depending on whether we need a second pass
+    const auto c1 = successor(child(id, nw), jump);
+    const auto c2 = successor(join(q(id, nw, ne), q(id, ne, nw),
+                                   q(id, nw, se), q(id, ne, sw)),
+                              jump);
+    const auto c3 = successor(child(id, ne), jump);
+    const auto c4 = successor(join(q(id, nw, sw), q(id, nw, se),
+                                   q(id, sw, nw), q(id, sw, ne)),
+                              jump);
+    const auto c5 = successor(join(q(id, nw, se), q(id, ne, sw),
+                                   q(id, sw, ne), q(id, se, nw)),
+                              jump);
+    const auto c6 = successor(join(q(id, ne, sw), q(id, ne, se),
+                                   q(id, se, nw), q(id, se, ne)),
+                              jump);
+    const auto c7 = successor(child(id, sw), jump);
+    const auto c8 = successor(join(q(id, sw, ne), q(id, se, nw),
+                                   q(id, sw, se), q(id, se, sw)),
+                              jump);
+    const auto c9 = successor(child(id, se), jump);
+
+    node_id result{};
+    if (jump < level - 2) {
+      // the sub-squares are already far enough along, just re-assemble
+      // the center from their centers
+      const auto center = [&](node_id a, node_id b, node_id c, node_id d) {
+        return join(child(a, se), child(b, sw), child(c, ne), child(d, nw));
+      };
+      result = join(center(c1, c2, c4, c5), center(c2, c3, c5, c6),
+                    center(c4, c5, c7, c8), center(c5, c6, c8, c9));
+    } else {
+      result = join(successor(join(c1, c2, c4, c5), jump),
+                    successor(join(c2, c3, c5, c6), jump),
+                    successor(join(c4, c5, c7, c8), jump),
+                    successor(join(c5, c6, c8, c9), jump));
+    }
+
+    m_successors.emplace(key, result);
+    return result;
+  }
+
+  void advance_pow2(std::size_t jump) {
+    // the result is the center half of the universe, which has to be big
+    // enough to hold the whole board
+    const auto level = std::max(torus_level + 1, jump + 2);
+    const auto offset = size(level - 2);
+
+    // the universe starts `offset` cells up / left of the board, so that
+    // its center starts exactly at 0,0
+    m_windows.clear();
+    const auto universe = tiled_window(level, (Width - offset % Width) % Width,
+                                       (Height - offset % Height) % Height);
+    const auto result = successor(universe, jump);
+
+    m_torus =
+        crop(descend(result, level - 1, 0, 0, torus_level), torus_level, 0, 0);
+
+    if (m_nodes.size() > max_nodes) {
+      collect_garbage();
+    }
+  }
+
+  // Start over with only the nodes needed for the current state
+  void collect_garbage() {
+    std::vector<bool> cells(Width * Height);
+    for_each_alive(
+        [&](std::size_t x, std::size_t y) { cells[y * Width + x] = true; });
+
+    reset();
+    m_torus = build(torus_level, 0, 0, [&](std::size_t x, std::size_t y) {
+      return static_cast<bool>(cells[y * Width + x]);
+    });
+  }
+};
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef CPP_WEEKLY_LIFE_RULE_HPP
+#define CPP_WEEKLY_LIFE_RULE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// Life-like rules: which neighbor counts make a dead cell alive ("B") and
+// which let a live one survive ("S"), one bit per count.
+struct LifeRule {
+  std::uint16_t born = 0;
+  std::uint16_t survives = 0;
+
+  constexpr bool operator==(const LifeRule &) const = default;
+
+  // born in the low 9 bits, survives in the 9 above, so the next state is
+  // a single shift no matter what the rule is
+  [[nodiscard]] constexpr std::uint32_t transitions() const {
+    return born | (std::uint32_t{survives} << 9);
+  }
+
+  [[nodiscard]] constexpr bool next(bool is_alive,
+                                    unsigned neighbors) const {
+    return ((transitions() >> (neighbors + 9u * is_alive)) & 1u) != 0;
+  }
+};
+
+// Parses rulestrings like "B3/S23" (case does not matter, either half can
+// come first, and either can be empty, "B2/S"), or the older "23/3"
+// survives/born notation
+[[nodiscard]] constexpr std::optional<LifeRule>
+parse_rule(std::string_view rulestring) {
+  const auto slash = rulestring.find('/');
+  if (slash == std::string_view::npos) {
+    return std::nullopt;
+  }
+
+  const auto parse_counts =
+      [](std::string_view counts) -> std::optional<std::uint16_t> {
+    std::uint16_t result = 0;
+    for (const auto digit : counts) {
+      if (digit < '0' || digit > '8') {
+        return std::nullopt;
+      }
+      result = static_cast<std::uint16_t>(result | (1u << (digit - '0')));
+    }
+    return result;
+  };
+
+  const auto prefix = [](std::string_view part) {
+    return part.empty() ? '\0' : static_cast<char>(part.front() | 0x20);
+  };
+
+  auto first = rulestring.substr(0, slash);
+  auto second = rulestring.substr(slash + 1);
+
+  if (prefix(first) != 'b' && prefix(first) != 's') {
+    // S/B, the halves are bare digits
+    const auto survives = parse_counts(first);
+    const auto born = parse_counts(second);
+    if (!survives || !born) {
+      return std::nullopt;
+    }
+    return LifeRule{*born, *survives};
+  }
+
+  if (prefix(first) == 's') {
+    std::swap(first, second);
+  }
+  if (prefix(first) != 'b' || prefix(second) != 's') {
+    return std::nullopt;
+  }
+
+  const auto born = parse_counts(first.substr(1));
+  const auto survives = parse_counts(second.substr(1));
+  if (!born || !survives) {
+    return std::nullopt;
+  }
+  return LifeRule{*born, *survives};
+}
+
+[[nodiscard]] inline std::string to_string(LifeRule rule) {
+  std::string result = "B";
+  const auto append_counts = [&](std::uint16_t counts) {
+    for (char count = 0; count <= 8; ++count) {
+      if ((counts >> count) & 1u) {
+        result += static_cast<char>('0' + count);
+      }
+    }
+  };
+  append_counts(rule.born);
+  result += "/S";
+  append_counts(rule.survives);
+  return result;
+}
+
+inline constexpr LifeRule conway_rule = *parse_rule("B3/S23");
+
+struct NamedRule {
+  std::string_view name;
+  LifeRule rule;
+};
+
+// Rules that get a kernel compiled for them, anything else is looked up in
+// a table at runtime
+inline constexpr std::array known_rules{
+    NamedRule{"conway", conway_rule},
+    NamedRule{"highlife", *parse_rule("B36/S23")},
+    NamedRule{"day_and_night", *parse_rule("B3678/S34678")},
+    NamedRule{"seeds", *parse_rule("B2/S")},
+    NamedRule{"life_without_death", *parse_rule("B3/S012345678")},
+    NamedRule{"maze", *parse_rule("B3/S12345")},
+    NamedRule{"two_by_two", *parse_rule("B36/S125")},
+    NamedRule{"replicator", *parse_rule("B1357/S1357")}};
+
+// A rule fixed at compile time. This turns into one compare per neighbor
+// count that is part of the rule, for Conway that is exactly
+// `neighbors == 3 || (is_alive && neighbors == 2)`, which vectorizes far
+// better than the shift through the runtime table.
+template <LifeRule Rule> struct StaticRule {
+  static constexpr LifeRule rule = Rule;
+
+  [[nodiscard]] constexpr bool operator()(bool is_alive,
+                                          unsigned neighbors) const {
+    return [&]<std::size_t... Counts>(std::index_sequence<Counts...>) {
+      constexpr auto in = [](std::uint16_t counts, std::size_t count) {
+        return ((counts >> count) & 1u) != 0;
+      };
+      const bool born =
+          (false | ... | (in(Rule.born, Counts) && neighbors == Counts));
+      const bool survives =
+          (false | ... | (in(Rule.survives, Counts) && neighbors == Counts));
+      if constexpr ((Rule.born & ~Rule.survives) == 0) {
+        // everything that is born would also survive, no need to look at
+        // the cell itself for that
+        return born | (is_alive & survives);
+      } else {
+        return (!is_alive & born) | (is_alive & survives);
+      }
+    }(std::make_index_sequence<9>{});
+  }
+};
+
+using ConwayRule = StaticRule<conway_rule>;
+
+// Any rule, decided at runtime
+struct DynamicRule {
+  LifeRule rule;
+
+  [[nodiscard]] constexpr bool operator()(bool is_alive,
+                                          unsigned neighbors) const {
+    return rule.next(is_alive, neighbors);
+  }
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef CPP_WEEKLY_LOOKUP_BOARD_HPP
+#define CPP_WEEKLY_LOOKUP_BOARD_HPP
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include "life_rule.hpp"
+#include "tiled_board.hpp"
+
+// Table driven stepping for byte-per-cell boards (GameBoard).
+//
+// A cell's next state depends only on its 3x3 neighborhood, which is 9 bits,
+// so all 512 answers are computed at compile time. Walking along a row the
+// neighborhood of the next cell is the current one shifted over by one
+// column plus one new column, so each cell costs 3 loads, a shift, an OR
+// and a table load, instead of 8 loads and adds and the rule.
+//
+// A 4x4 block -> 2x2 result table (65536 entries) would do 4 cells per
+// lookup, but it no longer fits in L1 next to the rows, and gathering 16
+// separate bytes for it costs more than it saves.
+//
+// Index layout, three bits per column, oldest column in the high bits:
+//
+//   bit:    8 7 6 | 5 4 3 | 2 1 0
+//   column: x - 1 |   x   | x + 1
+//   row:    b m a | b m a | b m a    (above, middle, below)
+
+template <LifeRule Rule> inline constexpr auto lookup_table = [] {
+  std::array<std::uint8_t, 512> result{};
+  for (unsigned index = 0; index < result.size(); ++index) {
+    const bool is_alive = ((index >> 4) & 1u) != 0;
+    const auto neighbors =
+        static_cast<unsigned>(std::popcount(index)) - (is_alive ? 1u : 0u);
+    result[index] = Rule.next(is_alive, neighbors);
+  }
+  return result;
+}();
+
+// The 3 cells of column x, as the low 3 bits of the index
+template <typename Cell>
+[[nodiscard]] constexpr unsigned lookup_column(const Cell *above,
+                                               const Cell *middle,
+                                               const Cell *below,
+                                               std::size_t x) {
+  return static_cast<unsigned>(above[x]) |
+         (static_cast<unsigned>(middle[x]) << 1u) |
+         (static_cast<unsigned>(below[x]) << 2u);
+}
+
+// Computes one output row from the 3 input rows around it, sliding the
+// index along the row. The wrapping columns are just where the index starts
+// and ends.
+template <LifeRule Rule = conway_rule, typename Cell>
+constexpr void iterate_lookup_row(const Cell *above, const Cell *middle,
+                                  const Cell *below, Cell *result,
+                                  std::size_t width) {
+  const auto &table = lookup_table<Rule>;
+
+  unsigned index = (lookup_column(above, middle, below, width - 1) << 3u) |
+                   lookup_column(above, middle, below, 0);
+
+  for (std::size_t x = 0; x + 1 < width; ++x) {
+    index = ((index << 3u) | lookup_column(above, middle, below, x + 1)) &
+            0x1FFu;
+    result[x] = static_cast<Cell>(table[index]);
+  }
+
+  index = ((index << 3u) | lookup_column(above, middle, below, 0)) & 0x1FFu;
+  result[width - 1] = static_cast<Cell>(table[index]);
+}
+
+// Row kernel for iterate_board_tiled
+template <LifeRule Rule = conway_rule> struct LookupRowKernel {
+  template <typename Cell>
+  constexpr void operator()(const Cell *above, const Cell *middle,
+                            const Cell *below, Cell *result,
+                            std::size_t width) const {
+    iterate_lookup_row<Rule>(above, middle, below, result, width);
+  }
+};
+
+#endif
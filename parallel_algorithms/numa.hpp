@@ -0,0 +1,124 @@
+#ifndef CPP_WEEKLY_NUMA_HPP
+#define CPP_WEEKLY_NUMA_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Just enough NUMA to see where pages ended up, using the raw syscalls so
+// we don't need libnuma. Everywhere else (or if the syscalls are blocked)
+// this all reports "don't know".
+
+// Node of the cpu we are currently running on
+[[nodiscard]] inline std::optional<int> current_numa_node() {
+#if defined(__linux__) && defined(SYS_getcpu)
+  unsigned cpu = 0;
+  unsigned node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+    return static_cast<int>(node);
+  }
+#endif
+  return std::nullopt;
+}
+
+// Where the pages of some memory are, not how often they are accessed from
+// another node: a remote page that is hardly touched counts as much as one
+// that is hit every generation
+struct PagePlacement {
+  std::size_t local = 0;
+  std::size_t remote = 0;
+  // not faulted in yet, or we could not ask
+  std::size_t unknown = 0;
+
+  PagePlacement &operator+=(const PagePlacement &rhs) {
+    local += rhs.local;
+    remote += rhs.remote;
+    unknown += rhs.unknown;
+    return *this;
+  }
+
+  // the share of the pages we know about that are on another node
+  [[nodiscard]] double remote_page_ratio() const {
+    const auto known = local + remote;
+    return known == 0 ? 0.0
+                      : static_cast<double>(remote) / static_cast<double>(known);
+  }
+};
+
+[[nodiscard]] inline std::uintptr_t page_size() {
+#ifdef __linux__
+  return static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+#else
+  return 4096;
+#endif
+}
+
+// Start of the page `address` is in
+[[nodiscard]] inline const void *page_floor(const void *address) {
+  return reinterpret_cast<const void *>(
+      reinterpret_cast<std::uintptr_t>(address) & ~(page_size() - 1));
+}
+
+// Counts how many of the pages that start in [begin, end) are on `node`.
+// Only counting the pages that start in the range means ranges next to each
+// other never count a page twice, pass page_floor(begin) to also count the
+// page that begin is in. Without a node (or without the syscall) every page
+// is unknown.
+[[nodiscard]] inline PagePlacement
+page_placement(const void *begin, const void *end,
+               [[maybe_unused]] std::optional<int> node) {
+  PagePlacement result;
+
+  const auto size = page_size();
+  auto page =
+      (reinterpret_cast<std::uintptr_t>(begin) + size - 1) & ~(size - 1);
+  const auto last = reinterpret_cast<std::uintptr_t>(end);
+  if (page >= last) {
+    return result;
+  }
+
+#if defined(__linux__) && defined(SYS_move_pages)
+  if (!node) {
+    result.unknown = (last - page + size - 1) / size;
+    return result;
+  }
+
+  // move_pages without target nodes only reports where the pages are
+  std::array<void *, 1024> pages{};
+  std::array<int, 1024> status{};
+  while (page < last) {
+    std::size_t count = 0;
+    for (; count < pages.size() && page < last; ++count, page += size) {
+      pages[count] = reinterpret_cast<void *>(page);
+    }
+
+    if (syscall(SYS_move_pages, 0, count, pages.data(), nullptr,
+                status.data(), 0) != 0) {
+      result.unknown += count;
+      continue;
+    }
+
+    for (std::size_t index = 0; index < count; ++index) {
+      if (status[index] < 0) {
+        ++result.unknown;
+      } else if (status[index] == *node) {
+        ++result.local;
+      } else {
+        ++result.remote;
+      }
+    }
+  }
+#else
+  result.unknown = (last - page + size - 1) / size;
+#endif
+
+  return result;
+}
+
+#endif
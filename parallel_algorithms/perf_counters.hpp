@@ -0,0 +1,234 @@
+#ifndef CPP_WEEKLY_PERF_COUNTERS_HPP
+#define CPP_WEEKLY_PERF_COUNTERS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware counters from inside the process, so they can be read around
+// just the part we care about instead of wrapping the whole program in
+// `perf stat`. Uses perf_event_open directly, where that doesn't exist or
+// isn't allowed (containers, perf_event_paranoid, other OSes) every count
+// is just missing.
+//
+// The counters follow child threads, but only threads created after they
+// were opened, so open them (call perf_counters()) before any worker
+// threads are started.
+
+// The same events, in the same order, as `perf stat -e` in
+// run_performance_tests.sh
+enum class PerfEvent : std::size_t {
+  cycles,
+  cache_references,
+  cache_misses,
+  instructions,
+  branches,
+  branch_misses
+};
+
+inline constexpr std::size_t perf_event_count = 6;
+
+struct PerfSample {
+  std::array<std::optional<double>, perf_event_count> counts{};
+
+  [[nodiscard]] std::optional<double> operator[](PerfEvent event) const {
+    return counts[static_cast<std::size_t>(event)];
+  }
+
+  PerfSample &operator+=(const PerfSample &rhs) {
+    for (std::size_t index = 0; index < counts.size(); ++index) {
+      if (counts[index] && rhs.counts[index]) {
+        *counts[index] += *rhs.counts[index];
+      } else {
+        counts[index].reset();
+      }
+    }
+    return *this;
+  }
+
+  [[nodiscard]] PerfSample operator-(const PerfSample &rhs) const {
+    PerfSample result;
+    for (std::size_t index = 0; index < counts.size(); ++index) {
+      if (counts[index] && rhs.counts[index]) {
+        result.counts[index] = *counts[index] - *rhs.counts[index];
+      }
+    }
+    return result;
+  }
+
+  [[nodiscard]] std::optional<double> ratio(PerfEvent numerator,
+                                            PerfEvent denominator) const {
+    const auto top = (*this)[numerator];
+    const auto bottom = (*this)[denominator];
+    if (!top || !bottom || *bottom == 0) {
+      return std::nullopt;
+    }
+    return *top / *bottom;
+  }
+};
+
+class PerfCounters {
+public:
+  PerfCounters() {
+#if defined(__linux__) && defined(SYS_perf_event_open)
+    constexpr std::array<std::uint64_t, perf_event_count> configs{
+        PERF_COUNT_HW_CPU_CYCLES,       PERF_COUNT_HW_CACHE_REFERENCES,
+        PERF_COUNT_HW_CACHE_MISSES,     PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_BRANCH_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES};
+
+    for (std::size_t index = 0; index < configs.size(); ++index) {
+      perf_event_attr attributes{};
+      attributes.size = sizeof(attributes);
+      attributes.type = PERF_TYPE_HARDWARE;
+      attributes.config = configs[index];
+      attributes.read_format =
+          PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      attributes.inherit = 1;
+      // allowed without privileges, and the stepping loops are user space
+      // anyway
+      attributes.exclude_kernel = 1;
+      attributes.exclude_hv = 1;
+
+      // not a group, the kernel can't read inherited groups
+      m_fds[index] = static_cast<int>(
+          syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+    }
+#endif
+  }
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  ~PerfCounters() {
+#ifdef __linux__
+    for (const auto fd : m_fds) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+#endif
+  }
+
+  [[nodiscard]] bool available() const {
+    for (const auto fd : m_fds) {
+      if (fd >= 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Counts since the counters were opened, scaled up for the time a
+  // counter was not running if the kernel had to multiplex them
+  [[nodiscard]] PerfSample read() const {
+    PerfSample result;
+#ifdef __linux__
+    for (std::size_t index = 0; index < m_fds.size(); ++index) {
+      // value, time enabled, time running
+      std::array<std::uint64_t, 3> values{};
+      if (m_fds[index] < 0 ||
+          ::read(m_fds[index], values.data(), sizeof(values)) !=
+              static_cast<ssize_t>(sizeof(values)) ||
+          values[2] == 0) {
+        continue;
+      }
+      result.counts[index] = static_cast<double>(values[0]) *
+                             static_cast<double>(values[1]) /
+                             static_cast<double>(values[2]);
+    }
+#endif
+    return result;
+  }
+
+private:
+  std::array<int, perf_event_count> m_fds{-1, -1, -1, -1, -1, -1};
+};
+
+// The counters for the whole process, opened on first use
+[[nodiscard]] inline const PerfCounters &perf_counters() {
+  static const PerfCounters counters;
+  return counters;
+}
+
+// The counter columns of performance_stats.csv, "Cycles" through
+// "Branch Miss Ratio", formatted like perf stat's. Missing counts are
+// empty fields.
+[[nodiscard]] inline std::string perf_csv_fields(const PerfSample &sample) {
+  std::ostringstream out;
+  out << std::fixed;
+
+  const auto count = [&](PerfEvent event) {
+    if (const auto value = sample[event]) {
+      out << std::setprecision(0) << *value;
+    }
+  };
+  const auto percent = [&](PerfEvent numerator, PerfEvent denominator) {
+    if (const auto value = sample.ratio(numerator, denominator)) {
+      out << std::setprecision(2) << *value * 100 << '%';
+    }
+  };
+
+  count(PerfEvent::cycles);
+  out << ',';
+  count(PerfEvent::cache_references);
+  out << ',';
+  count(PerfEvent::cache_misses);
+  out << ',';
+  percent(PerfEvent::cache_misses, PerfEvent::cache_references);
+  out << ',';
+  count(PerfEvent::instructions);
+  out << ',';
+  if (const auto ipc =
+          sample.ratio(PerfEvent::instructions, PerfEvent::cycles)) {
+    out << std::setprecision(2) << *ipc;
+  }
+  out << ',';
+  count(PerfEvent::branches);
+  out << ',';
+  count(PerfEvent::branch_misses);
+  out << ',';
+  percent(PerfEvent::branch_misses, PerfEvent::branches);
+
+  return out.str();
+}
+
+// One line for people, the parts of perf_csv_fields that compare across
+// board sizes
+[[nodiscard]] inline std::string perf_summary(const PerfSample &sample) {
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(2);
+
+  const auto field = [&](std::string_view name, std::optional<double> value,
+                         double scale, std::string_view unit) {
+    out << name << ": ";
+    if (value) {
+      out << *value * scale << unit;
+    } else {
+      out << "n/a";
+    }
+  };
+
+  field("Instructions Per Cycle",
+        sample.ratio(PerfEvent::instructions, PerfEvent::cycles), 1, "");
+  out << ", ";
+  field("Cache Miss Ratio",
+        sample.ratio(PerfEvent::cache_misses, PerfEvent::cache_references),
+        100, "%");
+  out << ", ";
+  field("Branch Miss Ratio",
+        sample.ratio(PerfEvent::branch_misses, PerfEvent::branches), 100, "%");
+  return out.str();
+}
+
+#endif
@@ -0,0 +1,415 @@
+#ifndef CPP_WEEKLY_RECORDER_HPP
+#define CPP_WEEKLY_RECORDER_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "game_board.hpp"
+#include "snapshot.hpp"
+
+// Records generations of a run to a file (".golr") for looking at later,
+// and reads them back.
+//
+// Frames are bit packed like BitBoard, 64 cells per word and every row
+// padded to whole words. Each frame is XORed with the one before it, so
+// only the cells that changed are set, and that is stored as
+//
+//   varint zero words, varint literal words, the literal words, ...
+//
+// which makes a frame where little happened (nearly all zero words) a
+// few bytes. Every keyframe_interval-th frame is XORed with an empty frame
+// instead, so a reader only ever has to decode from the keyframe before
+// the frame it wants.
+//
+// The file is a RecordingHeader, then per frame a FrameHeader followed by
+// payload_size bytes of the encoding above.
+
+struct RecordingHeader {
+  std::array<char, 4> magic;
+  std::uint32_t version;
+  std::uint64_t width;
+  std::uint64_t height;
+  std::uint64_t keyframe_interval;
+};
+
+struct FrameHeader {
+  std::uint64_t generation;
+  std::uint32_t is_keyframe;
+  std::uint32_t reserved;
+  std::uint64_t payload_size;
+};
+
+static_assert(sizeof(RecordingHeader) == 32);
+static_assert(sizeof(FrameHeader) == 24);
+
+inline constexpr std::array<char, 4> recording_magic{'G', 'O', 'L', 'R'};
+inline constexpr std::uint32_t recording_version = 1;
+
+[[nodiscard]] constexpr std::size_t packed_words_per_row(std::size_t width) {
+  return (width + 63) / 64;
+}
+
+// Any board into packed rows, words must be
+// packed_words_per_row(width) * height big
+template <typename BoardType>
+void pack_board(const BoardType &board, std::span<std::uint64_t> words) {
+  const auto width = static_cast<std::size_t>(BoardType::width);
+  const auto height = static_cast<std::size_t>(BoardType::height);
+  const auto words_per_row = packed_words_per_row(width);
+
+  if constexpr (requires { BoardType::words_per_row; }) {
+    // already in this layout
+    std::copy(board.data.begin(), board.data.end(), words.begin());
+  } else {
+    std::fill(words.begin(), words.end(), std::uint64_t{0});
+    for (std::size_t y = 0; y < height; ++y) {
+      auto *row = words.data() + y * words_per_row;
+      for (std::size_t x = 0; x < width; ++x) {
+        if constexpr (std::is_same_v<
+                          typename decltype(BoardType::data)::value_type,
+                          bool>) {
+          row[x / 64] |= std::uint64_t{board.data[y * width + x]} << (x % 64);
+        } else {
+          row[x / 64] |= std::uint64_t{board[make_point<BoardType>(x, y)]}
+                         << (x % 64);
+        }
+      }
+    }
+  }
+}
+
+// Packed rows back into any board, cut off at its edges
+template <typename BoardType>
+void unpack_board(std::span<const std::uint64_t> words, std::size_t width,
+                  std::size_t height, BoardType &board) {
+  const auto words_per_row = packed_words_per_row(width);
+
+  board.data.fill({});
+  for (std::size_t y = 0; y < height; ++y) {
+    for (std::size_t word = 0; word < words_per_row; ++word) {
+      auto bits = words[y * words_per_row + word];
+      while (bits != 0) {
+        const auto bit = static_cast<std::size_t>(std::countr_zero(bits));
+        set_run(board, word * 64 + bit, y, 1);
+        bits &= bits - 1;
+      }
+    }
+  }
+}
+
+namespace recorder_detail {
+inline void encode_frame(std::span<const std::uint64_t> words,
+                         std::vector<std::byte> &out) {
+  out.clear();
+  const auto is_zero = [](std::uint64_t word) { return word == 0; };
+
+  auto position = words.begin();
+  while (position != words.end()) {
+    const auto literals = std::find_if_not(position, words.end(), is_zero);
+    const auto zeros = std::find_if(literals, words.end(), is_zero);
+
+    const auto zero_count = static_cast<std::size_t>(literals - position);
+    const auto literal_count = static_cast<std::size_t>(zeros - literals);
+    snapshot_detail::append_varint(out, zero_count);
+    snapshot_detail::append_varint(out, literal_count);
+    // not &*literals, that is words.end() when the frame ends in zeros
+    const auto *literal_bytes = reinterpret_cast<const std::byte *>(
+        words.data() + (literals - words.begin()));
+    out.insert(out.end(), literal_bytes,
+               literal_bytes + literal_count * sizeof(std::uint64_t));
+
+    position = zeros;
+  }
+}
+
+// XORs a frame encoded by encode_frame onto words
+inline void apply_frame(std::span<const std::byte> payload,
+                        std::span<std::uint64_t> words) {
+  std::size_t position = 0;
+  std::size_t word = 0;
+  while (position < payload.size()) {
+    const auto zeros = snapshot_detail::read_varint(payload, position);
+    const auto literals = snapshot_detail::read_varint(payload, position);
+    if (zeros > words.size() - word ||
+        literals > words.size() - word - zeros ||
+        literals > (payload.size() - position) / sizeof(std::uint64_t)) {
+      throw std::runtime_error("recorded frame is corrupt");
+    }
+    word += zeros;
+    for (std::uint64_t index = 0; index < literals; ++index) {
+      words[word++] ^= snapshot_detail::read_at<std::uint64_t>(payload,
+                                                               position);
+      position += sizeof(std::uint64_t);
+    }
+  }
+}
+} // namespace recorder_detail
+
+// Writes frames on a background thread, so the stepping loop never waits
+// for the disk. The stepping thread only packs the board into one of
+// queue_size recycled buffers. If the writer falls so far behind that all
+// of them are queued up, record() waits for one (stalls() counts how
+// often), rather than letting the queue eat all the memory.
+class FrameRecorder {
+public:
+  FrameRecorder(const std::filesystem::path &path, std::size_t width,
+                std::size_t height, std::size_t keyframe_interval = 64,
+                std::size_t queue_size = 8)
+      : m_file(path, std::ios::binary),
+        m_frame_words(packed_words_per_row(width) * height),
+        m_keyframe_interval(std::max<std::size_t>(keyframe_interval, 1)) {
+    if (!m_file) {
+      throw std::runtime_error("cannot write " + path.string());
+    }
+
+    const RecordingHeader header{recording_magic, recording_version, width,
+                                 height, m_keyframe_interval};
+    m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    for (std::size_t index = 0; index < std::max<std::size_t>(queue_size, 1);
+         ++index) {
+      m_free.push_back(Frame{0, std::vector<std::uint64_t>(m_frame_words)});
+    }
+    m_writer = std::thread([this] { writer_loop(); });
+  }
+
+  FrameRecorder(const FrameRecorder &) = delete;
+  FrameRecorder &operator=(const FrameRecorder &) = delete;
+
+  // Writes out everything still queued
+  ~FrameRecorder() {
+    {
+      std::scoped_lock lock(m_mutex);
+      m_stopping = true;
+    }
+    m_frame_queued.notify_one();
+    m_writer.join();
+  }
+
+  // Generations have to be recorded in increasing order
+  template <typename BoardType>
+  void record(std::uint64_t generation, const BoardType &board) {
+    if (packed_words_per_row(static_cast<std::size_t>(BoardType::width)) *
+            static_cast<std::size_t>(BoardType::height) !=
+        m_frame_words) {
+      throw std::invalid_argument("board is not the size being recorded");
+    }
+
+    Frame frame;
+    {
+      std::unique_lock lock(m_mutex);
+      if (m_failed) {
+        throw std::runtime_error("writing the recording failed");
+      }
+      if (m_free.empty()) {
+        ++m_stalls;
+        m_frame_written.wait(lock, [&] { return !m_free.empty(); });
+      }
+      frame = std::move(m_free.back());
+      m_free.pop_back();
+    }
+
+    frame.generation = generation;
+    pack_board(board, frame.words);
+
+    {
+      std::scoped_lock lock(m_mutex);
+      m_queue.push_back(std::move(frame));
+    }
+    m_frame_queued.notify_one();
+  }
+
+  [[nodiscard]] std::size_t stalls() const {
+    std::scoped_lock lock(m_mutex);
+    return m_stalls;
+  }
+
+private:
+  struct Frame {
+    std::uint64_t generation = 0;
+    std::vector<std::uint64_t> words;
+  };
+
+  void writer_loop() {
+    std::vector<std::uint64_t> previous(m_frame_words);
+    std::vector<std::uint64_t> delta(m_frame_words);
+    std::vector<std::byte> payload;
+
+    for (std::size_t index = 0;; ++index) {
+      Frame frame;
+      {
+        std::unique_lock lock(m_mutex);
+        m_frame_queued.wait(lock,
+                            [&] { return m_stopping || !m_queue.empty(); });
+        if (m_queue.empty()) {
+          return;
+        }
+        frame = std::move(m_queue.front());
+        m_queue.pop_front();
+      }
+
+      const bool is_keyframe = index % m_keyframe_interval == 0;
+      if (is_keyframe) {
+        std::fill(previous.begin(), previous.end(), std::uint64_t{0});
+      }
+      std::transform(frame.words.begin(), frame.words.end(), previous.begin(),
+                     delta.begin(), std::bit_xor<>{});
+      // this frame is what the next one is compared to, and the old
+      // previous goes back to be filled again
+      std::swap(previous, frame.words);
+
+      recorder_detail::encode_frame(delta, payload);
+      const FrameHeader header{frame.generation, is_keyframe ? 1u : 0u, 0,
+                               payload.size()};
+      m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+      m_file.write(reinterpret_cast<const char *>(payload.data()),
+                   static_cast<std::streamsize>(payload.size()));
+
+      {
+        std::scoped_lock lock(m_mutex);
+        m_failed = m_failed || !m_file;
+        m_free.push_back(std::move(frame));
+      }
+      m_frame_written.notify_one();
+    }
+  }
+
+  std::ofstream m_file;
+  std::size_t m_frame_words;
+  std::size_t m_keyframe_interval;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_frame_queued;
+  std::condition_variable m_frame_written;
+  std::deque<Frame> m_queue;
+  std::vector<Frame> m_free;
+  std::size_t m_stalls = 0;
+  bool m_stopping = false;
+  bool m_failed = false;
+
+  std::thread m_writer;
+};
+
+// Reads a recording back. Opening it only walks the frame headers, and
+// reading a frame decodes forward from the frame read last if that is on
+// the way, from the keyframe before it otherwise.
+class FrameReader {
+public:
+  explicit FrameReader(const std::filesystem::path &path) : m_file(path) {
+    const auto bytes = m_file.bytes();
+    if (bytes.size() < sizeof(RecordingHeader)) {
+      throw std::runtime_error("recording is too short");
+    }
+    m_header = snapshot_detail::read_at<RecordingHeader>(bytes, 0);
+    if (m_header.magic != recording_magic) {
+      throw std::runtime_error("not a recording");
+    }
+    if (m_header.version != recording_version) {
+      throw std::runtime_error("unsupported recording version " +
+                               std::to_string(m_header.version));
+    }
+
+    // a frame cut off at the end (the recorder never finished) is ignored
+    std::size_t position = sizeof(RecordingHeader);
+    while (bytes.size() - position >= sizeof(FrameHeader)) {
+      const auto header =
+          snapshot_detail::read_at<FrameHeader>(bytes, position);
+      position += sizeof(FrameHeader);
+      if (header.payload_size > bytes.size() - position) {
+        break;
+      }
+      if (m_frames.empty() && header.is_keyframe == 0) {
+        throw std::runtime_error("recording does not start with a keyframe");
+      }
+      m_frames.push_back(
+          IndexedFrame{header.generation, header.is_keyframe != 0,
+                       bytes.subspan(position, header.payload_size)});
+      position += header.payload_size;
+    }
+
+    m_words.resize(packed_words_per_row(width()) * height());
+  }
+
+  [[nodiscard]] std::size_t width() const { return m_header.width; }
+  [[nodiscard]] std::size_t height() const { return m_header.height; }
+  [[nodiscard]] std::size_t frame_count() const { return m_frames.size(); }
+  [[nodiscard]] std::uint64_t generation(std::size_t frame) const {
+    return m_frames.at(frame).generation;
+  }
+
+  // Loads the last frame recorded at or before `generation` into board,
+  // and returns the generation it actually is
+  template <typename BoardType>
+  std::uint64_t seek(std::uint64_t generation, BoardType &board) {
+    const auto next = std::upper_bound(
+        m_frames.begin(), m_frames.end(), generation,
+        [](std::uint64_t value, const IndexedFrame &frame) {
+          return value < frame.generation;
+        });
+    if (next == m_frames.begin()) {
+      throw std::out_of_range("nothing was recorded by generation " +
+                              std::to_string(generation));
+    }
+
+    const auto target = static_cast<std::size_t>(next - m_frames.begin()) - 1;
+    decode_to(target);
+    unpack_board(m_words, width(), height(), board);
+    return m_frames[target].generation;
+  }
+
+private:
+  struct IndexedFrame {
+    std::uint64_t generation;
+    bool is_keyframe;
+    std::span<const std::byte> payload;
+  };
+
+  void decode_to(std::size_t target) {
+    auto keyframe = target;
+    while (!m_frames[keyframe].is_keyframe) {
+      --keyframe;
+    }
+
+    // if decoding fails part way, m_words is nothing in particular
+    const auto current = std::exchange(m_current, std::nullopt);
+
+    auto frame = keyframe;
+    if (current && *current >= keyframe && *current <= target) {
+      frame = *current + 1;
+    } else {
+      std::fill(m_words.begin(), m_words.end(), std::uint64_t{0});
+    }
+
+    for (; frame <= target; ++frame) {
+      recorder_detail::apply_frame(m_frames[frame].payload, m_words);
+    }
+    m_current = target;
+  }
+
+  MappedFile m_file;
+  RecordingHeader m_header{};
+  std::vector<IndexedFrame> m_frames;
+
+  // the frame m_current, decoded
+  std::vector<std::uint64_t> m_words;
+  std::optional<std::size_t> m_current;
+};
+
+#endif
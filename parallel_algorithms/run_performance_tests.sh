@@ -5,8 +5,9 @@ if [ $# -lt 2 ]; then
   exit 1
 fi
 
-# Check if necessary commands are available
-commands=("perf" "strip" "/usr/bin/time" "lscpu" "sha256sum")
+# Check if necessary commands are available. perf is only needed for
+# programs that don't measure themselves (see below)
+commands=("strip" "/usr/bin/time" "lscpu" "sha256sum")
 for cmd in "${commands[@]}"; do
   if ! command -v $cmd &> /dev/null; then
     echo "$cmd could not be found. Please install $cmd and try again."
@@ -18,6 +19,7 @@ SOURCE_FILE=$1
 NUM_RUNS=$2
 ADDITIONAL_FLAGS="${@:3}"
 OUTPUT_FILE="performance_stats.csv"
+COUNTERS_FILE="counters_output.csv"
 
 # Compiler and optimization flags
 COMPILERS=("/usr/lib/llvm16/bin/clang++"  "clang++" "g++")
@@ -29,7 +31,30 @@ CLANG_STDLIBS=("-stdlib=libc++" "-stdlib=libstdc++")
 CPU_MODEL=$(lscpu | grep "Model name" | awk -F: '{print $2}' | xargs)
 VIRTUALIZATION=$(lscpu | grep "Virtualization" | awk -F: '{print $2}' | xargs)
 VIRT_TYPE=$(lscpu | grep "Hypervisor vendor" | awk -F: '{print $2}' | xargs)
-SHA=$(sha256sum "$SOURCE_FILE" | awk '{print $1}')
+# The source plus the local headers it actually includes (what -MM lists,
+# which leaves out the system headers), so editing engines.hpp is a new
+# version of game_of_life.cpp but not of sources that never include it. A
+# source without local includes keeps its plain sha256sum, so its old rows
+# still match.
+DEPENDENCY_COMPILER=${CXX:-g++}
+if ! DEPENDENCIES=$($DEPENDENCY_COMPILER -MM $ADDITIONAL_FLAGS "$SOURCE_FILE" 2> /dev/null); then
+  echo "$DEPENDENCY_COMPILER -MM could not list the headers of $SOURCE_FILE (set CXX to pick another compiler)"
+  exit 1
+fi
+LOCAL_HEADERS=$(echo "$DEPENDENCIES" | tr -d '\\' | tr -s ' \n' '\n' | grep -v -e '^$' -e ':$' | grep -vxF "$SOURCE_FILE" | sort -u)
+if [ -z "$LOCAL_HEADERS" ]; then
+  SHA=$(sha256sum "$SOURCE_FILE" | awk '{print $1}')
+else
+  SHA=$(cat "$SOURCE_FILE" $LOCAL_HEADERS | sha256sum | awk '{print $1}')
+fi
+
+# Configurations are compiled BUILD_JOBS at a time, then run one at a time,
+# pinned to RUN_CPUS (a taskset cpu list like "2-7", ideally cores kept free
+# with isolcpus) if that is set. Each build goes in its own directory under
+# BUILD_DIR, so an interrupted sweep does not rebuild what it already built.
+BUILD_JOBS=${BUILD_JOBS:-$(nproc)}
+BUILD_DIR=${BUILD_DIR:-perf_builds}
+RUN_CPUS=${RUN_CPUS:-}
 
 # CSV header
 HEADER="Timestamp,Compiler,Version,Optimization,Architecture,Additional Flags,CPU Model,Virtualization,Virtualization Type,SHA,File Size (bytes),Stripped Size (bytes),Stdlib,Time (ms),RAM Usage (KB),Cycles,Cache References,Cache Misses,Cache Miss Ratio,Instructions,Instructions Per Cycle,Branches,Branch Misses,Branch Miss Ratio"
@@ -60,64 +85,153 @@ extract_perf_metrics() {
   echo "$cycles,$cache_references,$cache_misses,$cache_miss_ratio,$instructions,$instructions_per_cycle,$branches,$branch_misses,$branch_miss_ratio"
 }
 
-# Function to run tests and log results
-run_tests() {
+# Everything that identifies a measurement, as it appears in a CSV row
+row_key() {
   local compiler=$1
   local compiler_version=$2
   local opt=$3
   local arch=$4
-  local stdlib=$5
+  echo ",$compiler,$compiler_version,$opt,$arch,\"$ADDITIONAL_FLAGS\",\"$CPU_MODEL\",\"$VIRTUALIZATION\",\"$VIRT_TYPE\",\"$SHA\","
+}
+
+# How many runs of a configuration are already in the CSV
+measured_runs() {
+  local key=$1
+  local stdlib=$2
+  KEY="$key" STDLIB=",$stdlib," awk 'index($0, ENVIRON["KEY"]) && index($0, ENVIRON["STDLIB"])' "$OUTPUT_FILE" | wc -l
+}
 
-  echo "Compiling with $compiler $opt $arch $stdlib $ADDITIONAL_FLAGS..."
-  output_executable="a.out"
+build_dir() {
+  echo "$BUILD_DIR/$(echo "$SHA|$*|$ADDITIONAL_FLAGS" | sha256sum | cut -c1-16)"
+}
+
+# Compiles one configuration into its build directory, next to its
+# unstripped and stripped sizes. Only a finished build gets a "sizes" file.
+build_config() {
+  local compiler=$1
+  local opt=$2
+  local arch=$3
+  local stdlib=$4
+  local dir=$5
+
+  mkdir -p "$dir"
   if [[ "$compiler" == *"clang++" ]]; then
-    $compiler $opt $arch $stdlib $ADDITIONAL_FLAGS $SOURCE_FILE -o $output_executable
+    $compiler $opt $arch $stdlib $ADDITIONAL_FLAGS $SOURCE_FILE -o "$dir/a.out" &> "$dir/build.log"
   else
-    $compiler $opt $arch $ADDITIONAL_FLAGS $SOURCE_FILE -o $output_executable
+    $compiler $opt $arch $ADDITIONAL_FLAGS $SOURCE_FILE -o "$dir/a.out" &> "$dir/build.log"
   fi
 
   if [ $? -ne 0 ]; then
-    echo "Compilation failed for $compiler $opt $arch $stdlib $ADDITIONAL_FLAGS"
+    echo "Compilation failed for $compiler $opt $arch $stdlib $ADDITIONAL_FLAGS, see $dir/build.log"
     return
   fi
 
-  file_size=$(stat -c%s "$output_executable")
-  strip "$output_executable"
-  stripped_size=$(stat -c%s "$output_executable")
+  local file_size=$(stat -c%s "$dir/a.out")
+  strip "$dir/a.out"
+  echo "$file_size,$(stat -c%s "$dir/a.out")" > "$dir/sizes"
+  echo "Compiled $compiler $opt $arch $stdlib"
+}
 
-  for i in $(seq 1 $NUM_RUNS); do
-    echo "Running execution $i..."
+# Runs one built configuration until it has NUM_RUNS rows in the CSV. Every
+# run is appended as soon as it finishes, so an interrupted sweep picks up
+# where it stopped.
+run_tests() {
+  local compiler=$1
+  local compiler_version=$2
+  local opt=$3
+  local arch=$4
+  local stdlib=$5
+  local dir=$6
+  local done_runs=$7
+
+  if [ ! -f "$dir/sizes" ]; then
+    return
+  fi
+  local sizes=$(cat "$dir/sizes")
+
+  local pin=()
+  if [ -n "$RUN_CPUS" ]; then
+    pin=(taskset -c "$RUN_CPUS")
+  fi
+
+  for i in $(seq $((done_runs + 1)) $NUM_RUNS); do
+    echo "Running $compiler $opt $arch $stdlib, execution $i..."
+    rm -f "$COUNTERS_FILE"
     start_time=$(date +%s%N)
-    /usr/bin/time -v ./a.out 2> time_output.txt
+    GOL_PERF_CSV="$COUNTERS_FILE" "${pin[@]}" /usr/bin/time -v "$dir/a.out" 2> time_output.txt
     end_time=$(date +%s%N)
 
-    execution_time=$((($end_time - $start_time) / 1000000))  # in milliseconds
     ram_usage=$(grep "Maximum resident set size" time_output.txt | awk '{print $6}')
 
-    perf_output=$(perf stat -e cycles,cache-references,cache-misses,instructions,branches,branch-misses ./$output_executable 2> perf_output.txt)
-    cat perf_output.txt  # Debugging output
-    metrics=$(extract_perf_metrics "$(cat perf_output.txt)")
+    if [ -s "$COUNTERS_FILE" ]; then
+      # game_of_life.cpp measures just its stepping loops itself, the time
+      # and counters columns in one go (counters it could not open are empty)
+      IFS=, read -r execution_time metrics < "$COUNTERS_FILE"
+    else
+      # anything else is timed and counted as a whole process, the counters
+      # from a second run under perf
+      execution_time=$((($end_time - $start_time) / 1000000))  # in milliseconds
+      if command -v perf &> /dev/null; then
+        "${pin[@]}" perf stat -e cycles,cache-references,cache-misses,instructions,branches,branch-misses "$dir/a.out" > /dev/null 2> perf_output.txt
+        cat perf_output.txt  # Debugging output
+        metrics=$(extract_perf_metrics "$(cat perf_output.txt)")
+      else
+        metrics=",,,,,,,,"
+      fi
+    fi
 
     timestamp=$(date +"%Y-%m-%d %H:%M:%S")
-    echo "$timestamp,$compiler,$compiler_version,$opt,$arch,\"$ADDITIONAL_FLAGS\",\"$CPU_MODEL\",\"$VIRTUALIZATION\",\"$VIRT_TYPE\",\"$SHA\",$file_size,$stripped_size,$stdlib,$execution_time,$ram_usage,$metrics" >> "$OUTPUT_FILE"
+    echo "$timestamp,$compiler,$compiler_version,$opt,$arch,\"$ADDITIONAL_FLAGS\",\"$CPU_MODEL\",\"$VIRTUALIZATION\",\"$VIRT_TYPE\",\"$SHA\",$sizes,$stdlib,$execution_time,$ram_usage,$metrics" >> "$OUTPUT_FILE"
   done
 }
 
-# Main loop
+# Every configuration, as compiler|version|opt|arch|stdlib
+configurations=()
 for compiler in "${COMPILERS[@]}"; do
+  if ! command -v "$compiler" &> /dev/null; then
+    echo "Skipping $compiler, it could not be found"
+    continue
+  fi
   compiler_version=$($compiler --version | head -n 1)
   for opt in "${OPT_FLAGS[@]}"; do
     for arch in "${ARCH_FLAGS[@]}"; do
       if [[ "$compiler" == *"clang++" ]]; then
         for stdlib in "${CLANG_STDLIBS[@]}"; do
-          run_tests "$compiler" "$compiler_version" "$opt" "$arch" "$stdlib"
+          configurations+=("$compiler|$compiler_version|$opt|$arch|$stdlib")
         done
       else
-        stdlib="libstdc++"
-        run_tests "$compiler" "$compiler_version" "$opt" "$arch" "$stdlib"
+        configurations+=("$compiler|$compiler_version|$opt|$arch|libstdc++")
       fi
     done
   done
 done
 
+# Build everything that still needs runs, in parallel
+for configuration in "${configurations[@]}"; do
+  IFS='|' read -r compiler compiler_version opt arch stdlib <<< "$configuration"
+  dir=$(build_dir "$compiler" "$compiler_version" "$opt" "$arch" "$stdlib")
+  done_runs=$(measured_runs "$(row_key "$compiler" "$compiler_version" "$opt" "$arch")" "$stdlib")
+  if [ "$done_runs" -ge "$NUM_RUNS" ] || [ -f "$dir/sizes" ]; then
+    continue
+  fi
+
+  while [ "$(jobs -rp | wc -l)" -ge "$BUILD_JOBS" ]; do
+    wait -n
+  done
+  build_config "$compiler" "$opt" "$arch" "$stdlib" "$dir" &
+done
+wait
+
+# Then run them, one at a time, so they don't disturb each other
+for configuration in "${configurations[@]}"; do
+  IFS='|' read -r compiler compiler_version opt arch stdlib <<< "$configuration"
+  dir=$(build_dir "$compiler" "$compiler_version" "$opt" "$arch" "$stdlib")
+  done_runs=$(measured_runs "$(row_key "$compiler" "$compiler_version" "$opt" "$arch")" "$stdlib")
+  if [ "$done_runs" -ge "$NUM_RUNS" ]; then
+    echo "Skipping $compiler $opt $arch $stdlib, already measured $done_runs times"
+    continue
+  fi
+  run_tests "$compiler" "$compiler_version" "$opt" "$arch" "$stdlib" "$dir" "$done_runs"
+done
+
 echo "Performance data collected in $OUTPUT_FILE"
@@ -0,0 +1,215 @@
+#ifndef CPP_WEEKLY_SIMD_ROW_HPP
+#define CPP_WEEKLY_SIMD_ROW_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "life_rule.hpp"
+#include "tiled_board.hpp"
+
+// Hand vectorized row kernel for byte-per-cell boards (GameBoard).
+//
+// Each cell is one byte holding 0 or 1, so 32 (AVX2) or 64 (AVX-512) cells
+// have their 8 neighbors summed with plain byte adds of the shifted rows.
+// The next state is then looked up from the neighbor count with a byte
+// shuffle (pshufb), once in the "born" table and once in the "survives"
+// table, and the current cell state picks between the two.
+//
+// The instruction set is picked at runtime with CPUID, so the same binary
+// runs (with the scalar fallback) on hosts without AVX2. Builds that are not
+// gcc/clang on x86-64 only ever get the scalar version.
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define GOL_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// Born / survives lookup tables indexed by neighbor count, padded to the
+// 16 entries that a shuffle can index
+struct RuleTable {
+  std::array<std::uint8_t, 16> born;
+  std::array<std::uint8_t, 16> survives;
+};
+
+[[nodiscard]] constexpr RuleTable make_rule_table(LifeRule rule) {
+  RuleTable result{};
+  for (unsigned neighbors = 0; neighbors <= 8; ++neighbors) {
+    result.born[neighbors] = rule.next(false, neighbors);
+    result.survives[neighbors] = rule.next(true, neighbors);
+  }
+  return result;
+}
+
+inline constexpr RuleTable conway_rule_table = make_rule_table(conway_rule);
+
+enum class SimdLevel { scalar, avx2, avx512 };
+
+[[nodiscard]] constexpr std::string_view to_string(SimdLevel level) {
+  switch (level) {
+  case SimdLevel::avx2:
+    return "avx2";
+  case SimdLevel::avx512:
+    return "avx512";
+  default:
+    return "scalar";
+  }
+}
+
+[[nodiscard]] inline SimdLevel detect_simd_level() {
+#ifdef GOL_X86_SIMD
+  if (__builtin_cpu_supports("avx512bw")) {
+    return SimdLevel::avx512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return SimdLevel::avx2;
+  }
+#endif
+  return SimdLevel::scalar;
+}
+
+// checked once at startup
+inline const SimdLevel simd_level = detect_simd_level();
+
+#ifdef GOL_X86_SIMD
+
+// These return where they stopped, the scalar code picks up the remainder.
+// No lambdas in here, they would not inherit the target attribute.
+
+__attribute__((target("avx2"))) inline std::size_t
+iterate_span_avx2(const std::uint8_t *above, const std::uint8_t *middle,
+                  const std::uint8_t *below, std::uint8_t *result,
+                  std::size_t first, std::size_t last,
+                  const RuleTable &rules) {
+  const auto born = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(rules.born.data())));
+  const auto survives = _mm256_broadcastsi128_si256(_mm_loadu_si128(
+      reinterpret_cast<const __m128i *>(rules.survives.data())));
+
+  std::size_t x = first;
+  for (; x + 32 <= last; x += 32) {
+#define GOL_LOAD(row, offset)                                                  \
+  _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + x + offset))
+    const auto center = GOL_LOAD(middle, 0);
+
+    auto neighbors = _mm256_add_epi8(GOL_LOAD(above, -1), GOL_LOAD(above, 0));
+    neighbors = _mm256_add_epi8(neighbors, GOL_LOAD(above, 1));
+    neighbors = _mm256_add_epi8(neighbors, GOL_LOAD(middle, -1));
+    neighbors = _mm256_add_epi8(neighbors, GOL_LOAD(middle, 1));
+    neighbors = _mm256_add_epi8(neighbors, GOL_LOAD(below, -1));
+    neighbors = _mm256_add_epi8(neighbors, GOL_LOAD(below, 0));
+    neighbors = _mm256_add_epi8(neighbors, GOL_LOAD(below, 1));
+#undef GOL_LOAD
+
+    // 0 - 1 == 0xFF, the blend mask for live cells
+    const auto is_alive = _mm256_sub_epi8(_mm256_setzero_si256(), center);
+    const auto next = _mm256_blendv_epi8(_mm256_shuffle_epi8(born, neighbors),
+                                         _mm256_shuffle_epi8(survives, neighbors),
+                                         is_alive);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(result + x), next);
+  }
+  return x;
+}
+
+__attribute__((target("avx512f,avx512bw"))) inline std::size_t
+iterate_span_avx512(const std::uint8_t *above, const std::uint8_t *middle,
+                    const std::uint8_t *below, std::uint8_t *result,
+                    std::size_t first, std::size_t last,
+                    const RuleTable &rules) {
+  // (the maskz version, because gcc 12 warns about the undefined source
+  // register of the unmasked one)
+  const auto born = _mm512_maskz_broadcast_i32x4(
+      0xFFFF,
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(rules.born.data())));
+  const auto survives = _mm512_maskz_broadcast_i32x4(
+      0xFFFF, _mm_loadu_si128(
+                  reinterpret_cast<const __m128i *>(rules.survives.data())));
+
+  std::size_t x = first;
+  for (; x + 64 <= last; x += 64) {
+#define GOL_LOAD(row, offset) _mm512_loadu_si512(row + x + offset)
+    const auto center = GOL_LOAD(middle, 0);
+
+    auto neighbors = _mm512_add_epi8(GOL_LOAD(above, -1), GOL_LOAD(above, 0));
+    neighbors = _mm512_add_epi8(neighbors, GOL_LOAD(above, 1));
+    neighbors = _mm512_add_epi8(neighbors, GOL_LOAD(middle, -1));
+    neighbors = _mm512_add_epi8(neighbors, GOL_LOAD(middle, 1));
+    neighbors = _mm512_add_epi8(neighbors, GOL_LOAD(below, -1));
+    neighbors = _mm512_add_epi8(neighbors, GOL_LOAD(below, 0));
+    neighbors = _mm512_add_epi8(neighbors, GOL_LOAD(below, 1));
+#undef GOL_LOAD
+
+    const auto is_alive = _mm512_test_epi8_mask(center, center);
+    const auto next = _mm512_mask_blend_epi8(
+        is_alive, _mm512_shuffle_epi8(born, neighbors),
+        _mm512_shuffle_epi8(survives, neighbors));
+    _mm512_storeu_si512(result + x, next);
+  }
+  return x;
+}
+
+#endif
+
+// Same contract as iterate_dense_span: computes result[first, last) and
+// [first - 1, last + 1) of the input rows must be readable. `rules` has to
+// be make_rule_table(rule), the scalar remainder goes by `rule`.
+template <typename Cell>
+void iterate_dense_span_simd(const Cell *above, const Cell *middle,
+                             const Cell *below, Cell *result,
+                             std::size_t first, std::size_t last,
+                             LifeRule rule = conway_rule,
+                             const RuleTable &rules = conway_rule_table,
+                             SimdLevel level = simd_level) {
+  static_assert(sizeof(Cell) == 1, "the SIMD kernel needs one byte per cell");
+
+#ifdef GOL_X86_SIMD
+  const auto *above_bytes = reinterpret_cast<const std::uint8_t *>(above);
+  const auto *middle_bytes = reinterpret_cast<const std::uint8_t *>(middle);
+  const auto *below_bytes = reinterpret_cast<const std::uint8_t *>(below);
+  auto *result_bytes = reinterpret_cast<std::uint8_t *>(result);
+
+  // whatever is left over from the wider kernel goes to the narrower one
+  if (level == SimdLevel::avx512) {
+    first = iterate_span_avx512(above_bytes, middle_bytes, below_bytes,
+                                result_bytes, first, last, rules);
+  }
+  if (level >= SimdLevel::avx2) {
+    first = iterate_span_avx2(above_bytes, middle_bytes, below_bytes,
+                              result_bytes, first, last, rules);
+  }
+#else
+  static_cast<void>(rules);
+  static_cast<void>(level);
+#endif
+
+  iterate_dense_span(above, middle, below, result, first, last,
+                     DynamicRule{rule});
+}
+
+// Row kernel for iterate_board_tiled: the 2 wrapping columns are done with
+// the scalar code, everything in between with SIMD. Any life-like rule
+// works, the shuffle tables are built from it once.
+struct SimdRowKernel {
+  LifeRule rule = conway_rule;
+  SimdLevel level = simd_level;
+  RuleTable rules = make_rule_table(rule);
+
+  template <typename Cell>
+  void operator()(const Cell *above, const Cell *middle, const Cell *below,
+                  Cell *result, std::size_t width) const {
+    const DynamicRule scalar_rule{rule};
+    if (width < 3) {
+      iterate_dense_row(above, middle, below, result, width, scalar_rule);
+      return;
+    }
+    iterate_dense_row_range(above, middle, below, result, width, 0, 1,
+                            scalar_rule);
+    iterate_dense_row_range(above, middle, below, result, width, width - 1,
+                            width, scalar_rule);
+    iterate_dense_span_simd(above, middle, below, result, 1, width - 1, rule,
+                            rules, level);
+  }
+};
+
+#endif
@@ -0,0 +1,489 @@
+#ifndef CPP_WEEKLY_SNAPSHOT_HPP
+#define CPP_WEEKLY_SNAPSHOT_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "game_board.hpp"
+#include "life_rule.hpp"
+
+// Saving and loading boards, so big initial states don't have to be built
+// up one set() at a time.
+//
+// A snapshot (".gol") is laid out as:
+//
+//   SnapshotHeader
+//   std::uint64_t row_offsets[height + 1]   (into the row data)
+//   row data
+//
+// Each row is stored in whichever of these two forms is smaller:
+//
+//   * a bitmap: 1 bit per cell, so random noise costs 1 bit per cell
+//   * runs: alternating dead and live run lengths, as LEB128 varints,
+//     starting with a dead run and leaving out the trailing one, so a
+//     glider on an empty 10000 wide row costs a few bytes
+//
+// Everything has a fixed size and is little endian, so the header and the
+// offset table can be used straight out of a mapped file (see MappedFile)
+// without any parsing, and every row can be found without decoding the
+// ones before it. Loading is a single pass over the file.
+//
+// Standard Life ".rle" files (https://conwaylife.com/wiki/Run_Length_Encoded)
+// can be loaded as well, see load_rle().
+
+static_assert(std::endian::native == std::endian::little,
+              "snapshots are read in place, which assumes little endian");
+
+struct SnapshotHeader {
+  std::array<char, 4> magic;
+  std::uint32_t version;
+  std::uint64_t width;
+  std::uint64_t height;
+  std::uint64_t generation;
+  std::uint16_t born;
+  std::uint16_t survives;
+  std::uint32_t reserved;
+};
+
+static_assert(sizeof(SnapshotHeader) == 40);
+
+inline constexpr std::array<char, 4> snapshot_magic{'G', 'O', 'L', 'S'};
+inline constexpr std::uint32_t snapshot_version = 1;
+
+// the first byte of every row says how the rest of it is stored
+enum class RowEncoding : std::uint8_t { bitmap = 0, runs = 1 };
+
+// What a file said about the board in it
+struct SnapshotInfo {
+  std::size_t width = 0;
+  std::size_t height = 0;
+  LifeRule rule = conway_rule;
+  std::uint64_t generation = 0;
+};
+
+// Sets `length` cells from (x, y) to the right alive. Anything past the
+// edge of the board is dropped.
+template <typename BoardType>
+constexpr void set_run(BoardType &board, std::size_t x, std::size_t y,
+                       std::size_t length) {
+  const auto width = static_cast<std::size_t>(BoardType::width);
+  if (y >= static_cast<std::size_t>(BoardType::height) || x >= width) {
+    return;
+  }
+  length = std::min(length, width - x);
+
+  if constexpr (requires { BoardType::words_per_row; }) {
+    // bit packed, a word at a time
+    using word_t = typename BoardType::word_t;
+    constexpr auto bits_per_word = BoardType::bits_per_word;
+    auto *row = board.row(y);
+    while (length > 0) {
+      const auto bit = x % bits_per_word;
+      const auto count = std::min(length, bits_per_word - bit);
+      const auto mask = count == bits_per_word
+                            ? ~word_t{0}
+                            : ((word_t{1} << count) - 1) << bit;
+      row[x / bits_per_word] |= mask;
+      x += count;
+      length -= count;
+    }
+  } else if constexpr (std::is_same_v<
+                           typename decltype(BoardType::data)::value_type,
+                           bool>) {
+    // byte per cell (GameBoard)
+    std::fill_n(board.data.data() + y * width + x, length, true);
+  } else {
+    for (std::size_t index = 0; index < length; ++index) {
+      board.set(make_point<BoardType>(x + index, y));
+    }
+  }
+}
+
+namespace snapshot_detail {
+inline void append_varint(std::vector<std::byte> &out, std::uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<std::byte>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<std::byte>(value));
+}
+
+[[nodiscard]] constexpr std::size_t varint_size(std::uint64_t value) {
+  std::size_t result = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    ++result;
+  }
+  return result;
+}
+
+[[nodiscard]] inline std::uint64_t read_varint(std::span<const std::byte> bytes,
+                                               std::size_t &position) {
+  std::uint64_t result = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    if (position == bytes.size()) {
+      throw std::runtime_error("snapshot row ends in the middle of a run");
+    }
+    const auto byte = std::to_integer<std::uint64_t>(bytes[position++]);
+    result |= (byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return result;
+    }
+  }
+  throw std::runtime_error("snapshot run length is too long");
+}
+
+template <typename Value>
+[[nodiscard]] Value read_at(std::span<const std::byte> bytes,
+                            std::size_t position) {
+  Value result;
+  std::memcpy(&result, bytes.data() + position, sizeof(Value));
+  return result;
+}
+
+template <typename BoardType>
+void decode_row(std::span<const std::byte> row, std::size_t width,
+                std::size_t y, BoardType &board) {
+  if (row.empty()) {
+    throw std::runtime_error("snapshot row is empty");
+  }
+
+  const auto cells = row.subspan(1);
+  switch (static_cast<RowEncoding>(row[0])) {
+  case RowEncoding::bitmap:
+    if (cells.size() != (width + 7) / 8) {
+      throw std::runtime_error("snapshot bitmap row has the wrong size");
+    }
+    for (std::size_t byte = 0; byte < cells.size(); ++byte) {
+      // mostly empty bytes are skipped, and only the set bits visited
+      auto bits = std::to_integer<unsigned>(cells[byte]);
+      while (bits != 0) {
+        const auto bit = static_cast<std::size_t>(std::countr_zero(bits));
+        set_run(board, byte * 8 + bit, y, 1);
+        bits &= bits - 1;
+      }
+    }
+    return;
+  case RowEncoding::runs: {
+    std::size_t position = 0;
+    std::size_t x = 0;
+    bool alive = false;
+    while (position < cells.size()) {
+      const auto length = read_varint(cells, position);
+      if (length > width - x) {
+        throw std::runtime_error("snapshot row is longer than the board");
+      }
+      if (alive) {
+        set_run(board, x, y, length);
+      }
+      x += length;
+      alive = !alive;
+    }
+    return;
+  }
+  }
+  throw std::runtime_error("snapshot row has an unknown encoding");
+}
+} // namespace snapshot_detail
+
+// Encodes any board that can be indexed with a Point
+template <typename BoardType>
+[[nodiscard]] std::vector<std::byte>
+make_snapshot(const BoardType &board, LifeRule rule = conway_rule,
+              std::uint64_t generation = 0) {
+  const auto width = static_cast<std::size_t>(BoardType::width);
+  const auto height = static_cast<std::size_t>(BoardType::height);
+
+  const SnapshotHeader header{snapshot_magic, snapshot_version, width,
+                              height,         generation,       rule.born,
+                              rule.survives,  0};
+
+  std::vector<std::byte> result(sizeof(header) +
+                                (height + 1) * sizeof(std::uint64_t));
+  std::memcpy(result.data(), &header, sizeof(header));
+
+  const auto rows_begin = result.size();
+  const auto bitmap_size = (width + 7) / 8;
+  std::vector<std::uint64_t> runs;
+
+  for (std::size_t y = 0; y < height; ++y) {
+    const std::uint64_t offset = result.size() - rows_begin;
+    std::memcpy(result.data() + sizeof(header) + y * sizeof(offset), &offset,
+                sizeof(offset));
+
+    runs.clear();
+    std::size_t runs_size = 0;
+    bool alive = false;
+    std::size_t run_start = 0;
+    for (std::size_t x = 0; x <= width; ++x) {
+      const bool cell = x < width && board[make_point<BoardType>(x, y)];
+      if (x == width || cell != alive) {
+        if (x == width && !alive) {
+          // trailing dead cells are implied
+          break;
+        }
+        runs.push_back(x - run_start);
+        runs_size += snapshot_detail::varint_size(runs.back());
+        run_start = x;
+        alive = cell;
+      }
+    }
+
+    if (runs_size < bitmap_size) {
+      result.push_back(static_cast<std::byte>(RowEncoding::runs));
+      for (const auto run : runs) {
+        snapshot_detail::append_varint(result, run);
+      }
+    } else {
+      result.push_back(static_cast<std::byte>(RowEncoding::bitmap));
+      const auto bitmap_begin = result.size();
+      result.resize(bitmap_begin + bitmap_size);
+      for (std::size_t x = 0; x < width; ++x) {
+        if (board[make_point<BoardType>(x, y)]) {
+          result[bitmap_begin + x / 8] |= std::byte{1} << (x % 8);
+        }
+      }
+    }
+  }
+
+  const std::uint64_t end = result.size() - rows_begin;
+  std::memcpy(result.data() + sizeof(header) + height * sizeof(end), &end,
+              sizeof(end));
+  return result;
+}
+
+// Replaces the contents of board with a snapshot. A snapshot of a
+// different size is loaded into the top left corner, cut off at the edges.
+template <typename BoardType>
+SnapshotInfo load_snapshot(std::span<const std::byte> bytes,
+                           BoardType &board) {
+  using snapshot_detail::read_at;
+
+  if (bytes.size() < sizeof(SnapshotHeader)) {
+    throw std::runtime_error("snapshot is too short");
+  }
+  const auto header = read_at<SnapshotHeader>(bytes, 0);
+  if (header.magic != snapshot_magic) {
+    throw std::runtime_error("not a snapshot");
+  }
+  if (header.version != snapshot_version) {
+    throw std::runtime_error("unsupported snapshot version " +
+                             std::to_string(header.version));
+  }
+
+  const auto table_entries =
+      (bytes.size() - sizeof(SnapshotHeader)) / sizeof(std::uint64_t);
+  if (header.height >= table_entries) {
+    throw std::runtime_error("snapshot is missing rows");
+  }
+  const auto table = bytes.subspan(sizeof(SnapshotHeader));
+  const auto rows = table.subspan((header.height + 1) * sizeof(std::uint64_t));
+  const auto offset = [&](std::size_t y) {
+    return read_at<std::uint64_t>(table, y * sizeof(std::uint64_t));
+  };
+
+  board.data.fill({});
+
+  const auto height =
+      std::min<std::uint64_t>(header.height, BoardType::height);
+  for (std::size_t y = 0; y < height; ++y) {
+    const auto begin = offset(y);
+    const auto end = offset(y + 1);
+    if (begin > end || end > rows.size()) {
+      throw std::runtime_error("snapshot row offsets are out of range");
+    }
+    snapshot_detail::decode_row(rows.subspan(begin, end - begin), header.width,
+                                y, board);
+  }
+
+  return SnapshotInfo{header.width, header.height,
+                      LifeRule{header.born, header.survives},
+                      header.generation};
+}
+
+// Replaces the contents of board with the pattern in a ".rle" file, with
+// its top left corner at (origin_x, origin_y). Any letter other than `b`
+// counts as alive, so multi-state patterns load as their live cells.
+template <typename BoardType>
+SnapshotInfo load_rle(std::string_view text, BoardType &board,
+                      std::size_t origin_x = 0, std::size_t origin_y = 0) {
+  SnapshotInfo info;
+  const auto trim = [](std::string_view value) {
+    const auto first = value.find_first_not_of(" \t\r");
+    if (first == std::string_view::npos) {
+      return std::string_view{};
+    }
+    return value.substr(first,
+                        value.find_last_not_of(" \t\r") - first + 1);
+  };
+
+  // comment lines and the "x = 3, y = 3, rule = B3/S23" header
+  while (!text.empty()) {
+    const auto line_end = std::min(text.find('\n'), text.size());
+    const auto line = trim(text.substr(0, line_end));
+    if (!line.empty() && line.front() != '#') {
+      if (line.front() != 'x') {
+        break;
+      }
+      auto fields = line;
+      while (!fields.empty()) {
+        const auto field_end = std::min(fields.find(','), fields.size());
+        const auto field = fields.substr(0, field_end);
+        fields.remove_prefix(std::min(field_end + 1, fields.size()));
+
+        const auto equals = field.find('=');
+        if (equals == std::string_view::npos) {
+          throw std::runtime_error("bad rle header field: " +
+                                   std::string{field});
+        }
+        const auto key = trim(field.substr(0, equals));
+        const auto value = trim(field.substr(equals + 1));
+        if (key == "x") {
+          info.width = std::stoull(std::string{value});
+        } else if (key == "y") {
+          info.height = std::stoull(std::string{value});
+        } else if (key == "rule") {
+          // bounded grid suffixes ("B3/S23:T100,100") are ignored
+          const auto rule = parse_rule(value.substr(0, value.find(':')));
+          if (!rule) {
+            throw std::runtime_error("unsupported rle rule: " +
+                                     std::string{value});
+          }
+          info.rule = *rule;
+        }
+      }
+    }
+    text.remove_prefix(std::min(line_end + 1, text.size()));
+  }
+
+  board.data.fill({});
+
+  std::size_t x = 0;
+  std::size_t y = 0;
+  std::size_t count = 0;
+  for (const auto character : text) {
+    if (character >= '0' && character <= '9') {
+      count = count * 10 + static_cast<std::size_t>(character - '0');
+      continue;
+    }
+
+    const auto run = std::max(count, std::size_t{1});
+    count = 0;
+    if (character == '!') {
+      break;
+    } else if (character == '$') {
+      y += run;
+      x = 0;
+    } else if (character == 'b' || character == '.') {
+      x += run;
+    } else if ((character >= 'a' && character <= 'z') ||
+               (character >= 'A' && character <= 'Z')) {
+      set_run(board, origin_x + x, origin_y + y, run);
+      x += run;
+    } else if (character != ' ' && character != '\t' && character != '\r' &&
+               character != '\n') {
+      throw std::runtime_error(std::string{"bad character in rle: "} +
+                               character);
+    }
+  }
+
+  return info;
+}
+
+// A whole file, mapped read only where we can, read into memory otherwise
+class MappedFile {
+public:
+  explicit MappedFile(const std::filesystem::path &path) {
+#ifdef __linux__
+    if (const auto fd = ::open(path.c_str(), O_RDONLY); fd >= 0) {
+      struct stat status {};
+      if (::fstat(fd, &status) == 0 && status.st_size > 0) {
+        const auto size = static_cast<std::size_t>(status.st_size);
+        auto *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+          ::madvise(mapping, size, MADV_SEQUENTIAL);
+          m_mapping = mapping;
+          m_bytes = {static_cast<const std::byte *>(mapping), size};
+        }
+      }
+      ::close(fd);
+      if (m_mapping != nullptr) {
+        return;
+      }
+    }
+#endif
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+      throw std::runtime_error("cannot open " + path.string());
+    }
+    m_buffer.resize(std::filesystem::file_size(path));
+    file.read(reinterpret_cast<char *>(m_buffer.data()),
+              static_cast<std::streamsize>(m_buffer.size()));
+    m_bytes = m_buffer;
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  ~MappedFile() {
+#ifdef __linux__
+    if (m_mapping != nullptr) {
+      ::munmap(m_mapping, m_bytes.size());
+    }
+#endif
+  }
+
+  [[nodiscard]] std::span<const std::byte> bytes() const { return m_bytes; }
+
+private:
+  void *m_mapping = nullptr;
+  std::vector<std::byte> m_buffer;
+  std::span<const std::byte> m_bytes;
+};
+
+// Loads a ".rle" file or a snapshot, depending on the extension
+template <typename BoardType>
+SnapshotInfo load_board(const std::filesystem::path &path, BoardType &board) {
+  const MappedFile file(path);
+  if (path.extension() == ".rle") {
+    return load_rle(
+        std::string_view{reinterpret_cast<const char *>(file.bytes().data()),
+                         file.bytes().size()},
+        board);
+  }
+  return load_snapshot(file.bytes(), board);
+}
+
+template <typename BoardType>
+void save_board(const std::filesystem::path &path, const BoardType &board,
+                LifeRule rule = conway_rule, std::uint64_t generation = 0) {
+  const auto snapshot = make_snapshot(board, rule, generation);
+  std::ofstream file(path, std::ios::binary);
+  file.write(reinterpret_cast<const char *>(snapshot.data()),
+             static_cast<std::streamsize>(snapshot.size()));
+  if (!file) {
+    throw std::runtime_error("cannot write " + path.string());
+  }
+}
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef CPP_WEEKLY_TEMPORAL_BOARD_HPP
+#define CPP_WEEKLY_TEMPORAL_BOARD_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <execution>
+#include <memory>
+
+#include "simd_row.hpp"
+#include "tiled_board.hpp"
+
+// Temporal blocking for byte-per-cell boards (GameBoard).
+//
+// The tiled stepper still streams the whole board through memory once per
+// generation. Here every tile is copied into a small scratch area together
+// with a halo `generations` cells wide on every side, advanced that many
+// generations while it sits in cache, and only then written back.
+//
+// Every generation the valid part of the scratch area shrinks by one cell
+// on each side (the overlapped halo / trapezoid), so the halo is computed
+// redundantly by neighboring tiles, which is far cheaper than going back
+// to main memory. Because the halo is gathered with wraparound, the inner
+// loops never have to deal with the edges of the board at all.
+//
+// This only pays off with a kernel that is fast enough for memory to be
+// the bottleneck, so the rows are stepped with the SIMD span kernel. With
+// the compiler vectorized one the halo and the copies cost more than the
+// blocking saves.
+
+// The most generations advanced per trip through memory, which is what the
+// scratch buffers are sized for. Can be overridden with
+// -DGOL_TEMPORAL_GENERATIONS=..., TemporalEngine can do fewer at runtime.
+#ifndef GOL_TEMPORAL_GENERATIONS
+#define GOL_TEMPORAL_GENERATIONS 8
+#endif
+
+template <typename BoardType, std::size_t Generations> struct TemporalTiles {
+  using cell_type = typename decltype(BoardType::data)::value_type;
+
+  static constexpr auto width = static_cast<std::size_t>(BoardType::width);
+  static constexpr auto height = static_cast<std::size_t>(BoardType::height);
+
+  static constexpr std::size_t halo = Generations;
+
+  // wide rows are split up as well, so that a reasonable number of
+  // rows fit in the scratch area
+  static constexpr std::size_t tile_width = std::min<std::size_t>(width, 1024);
+  static constexpr std::size_t scratch_width = tile_width + 2 * halo;
+
+  // 2 scratch buffers (ping-pong) need to stay resident
+  static constexpr std::size_t scratch_rows =
+      GOL_L2_CACHE_BYTES / (2 * scratch_width * sizeof(cell_type));
+
+  // at least as tall as the halo, or we spend most of the time on the halo
+  static constexpr std::size_t tile_height = std::clamp<std::size_t>(
+      scratch_rows > 4 * halo ? scratch_rows - 2 * halo : 2 * halo, 1,
+      height);
+  static constexpr std::size_t scratch_height = tile_height + 2 * halo;
+
+  static constexpr std::size_t tiles_x = (width + tile_width - 1) / tile_width;
+  static constexpr std::size_t tiles_y =
+      (height + tile_height - 1) / tile_height;
+
+  static constexpr auto tiles = [] {
+    std::array<std::uint32_t, tiles_x * tiles_y> result{};
+    for (std::size_t tile = 0; tile < result.size(); ++tile) {
+      result[tile] = static_cast<std::uint32_t>(tile);
+    }
+    return result;
+  }();
+};
+
+// Copies `count` cells starting at `first` (already wrapped) out of a row,
+// wrapping around the end of the row as many times as needed
+template <typename Cell>
+void copy_wrapped_row(const Cell *row, std::size_t width, std::size_t first,
+                      std::size_t count, Cell *result) {
+  while (count > 0) {
+    const auto run = std::min(count, width - first);
+    result = std::copy_n(row + first, run, result);
+    count -= run;
+    first = 0;
+  }
+}
+
+// Advances one tile `generations` (1 to Generations) steps, the last of
+// them straight into `output`
+template <std::size_t Generations, typename BoardType>
+void iterate_temporal_tile(const BoardType &input, BoardType &output,
+                           std::size_t tile, std::size_t generations) {
+  using tiles = TemporalTiles<BoardType, Generations>;
+  using cell_type = typename tiles::cell_type;
+
+  constexpr auto width = tiles::width;
+  constexpr auto height = tiles::height;
+  constexpr auto scratch_width = tiles::scratch_width;
+
+  // par (not par_unseq) is used with this, so each thread is only ever
+  // working on one tile at a time and can keep reusing its buffers
+  using scratch_type =
+      std::array<cell_type, scratch_width * tiles::scratch_height>;
+  thread_local auto front = std::make_unique<scratch_type>();
+  thread_local auto back = std::make_unique<scratch_type>();
+
+  const auto tile_x = (tile % tiles::tiles_x) * tiles::tile_width;
+  const auto tile_y = (tile / tiles::tiles_x) * tiles::tile_height;
+  const auto tile_width = std::min(tiles::tile_width, width - tile_x);
+  const auto tile_height = std::min(tiles::tile_height, height - tile_y);
+
+  // only the halo we actually need for this many generations
+  const auto halo = generations;
+  const auto used_width = tile_width + 2 * halo;
+  const auto used_height = tile_height + 2 * halo;
+
+  // gather the tile plus its halo, this is the only place that wraps
+  const auto first_x = (tile_x + width * halo - halo) % width;
+  for (std::size_t y = 0; y < used_height; ++y) {
+    const auto source_y = (tile_y + height * halo - halo + y) % height;
+    copy_wrapped_row(input.data.data() + source_y * width, width, first_x,
+                     used_width, front->data() + y * scratch_width);
+  }
+
+  // each generation the correct region shrinks by 1 on every side
+  for (std::size_t generation = 1; generation < generations; ++generation) {
+    for (std::size_t y = generation; y < used_height - generation; ++y) {
+      const auto *middle = front->data() + y * scratch_width;
+      iterate_dense_span_simd(middle - scratch_width, middle,
+                              middle + scratch_width,
+                              back->data() + y * scratch_width, generation,
+                              used_width - generation);
+    }
+    std::swap(front, back);
+  }
+
+  // by the last generation only the tile itself is left, so it is written
+  // to the output directly instead of being copied back
+  for (std::size_t y = 0; y < tile_height; ++y) {
+    const auto *middle = front->data() + (y + halo) * scratch_width + halo;
+    iterate_dense_span_simd(middle - scratch_width, middle,
+                            middle + scratch_width,
+                            output.data.data() + (tile_y + y) * width + tile_x,
+                            0, tile_width);
+  }
+}
+
+// Advances the board by up to Generations generations in a single pass
+// through memory, returns how many it did
+template <std::size_t Generations = GOL_TEMPORAL_GENERATIONS,
+          typename BoardType>
+std::size_t iterate_board_temporal(const BoardType &input, BoardType &output,
+                                   std::size_t max_generations) {
+  using tiles = TemporalTiles<BoardType, Generations>;
+
+  const auto generations = std::min(Generations, max_generations);
+
+  const auto step_tile = [&](const auto tile) {
+    iterate_temporal_tile<Generations>(input, output, tile, generations);
+  };
+
+#ifndef SERIAL
+  std::for_each(std::execution::par, tiles::tiles.begin(), tiles::tiles.end(),
+                step_tile);
+#else
+  std::for_each(tiles::tiles.begin(), tiles::tiles.end(), step_tile);
+#endif
+
+  return generations;
+}
+
+#endif
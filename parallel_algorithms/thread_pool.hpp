@@ -0,0 +1,253 @@
+#ifndef CPP_WEEKLY_THREAD_POOL_HPP
+#define CPP_WEEKLY_THREAD_POOL_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Pins a thread to one cpu, does nothing where we don't know how
+inline void pin_to_cpu([[maybe_unused]] std::thread &thread,
+                       [[maybe_unused]] std::size_t cpu) {
+#ifdef __linux__
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(cpu % std::max(std::thread::hardware_concurrency(), 1u), &cpus);
+  pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+#endif
+}
+
+// Pins the calling thread to one cpu for as long as it lives, and puts back
+// whatever cpus it was allowed on before
+class ScopedCpuPin {
+public:
+  explicit ScopedCpuPin([[maybe_unused]] std::size_t cpu) {
+#ifdef __linux__
+    m_saved = pthread_getaffinity_np(pthread_self(), sizeof(m_previous),
+                                     &m_previous) == 0;
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu % std::max(std::thread::hardware_concurrency(), 1u), &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#endif
+  }
+
+  ScopedCpuPin(const ScopedCpuPin &) = delete;
+  ScopedCpuPin &operator=(const ScopedCpuPin &) = delete;
+
+  ~ScopedCpuPin() {
+#ifdef __linux__
+    if (m_saved) {
+      pthread_setaffinity_np(pthread_self(), sizeof(m_previous), &m_previous);
+    }
+#endif
+  }
+
+private:
+#ifdef __linux__
+  cpu_set_t m_previous{};
+  bool m_saved = false;
+#endif
+};
+
+// A small work-stealing thread pool, so that we have a parallel backend
+// that behaves the same everywhere, instead of depending on whether
+// (and which version of) TBB the standard library's parallel algorithms
+// were linked against.
+//
+// parallel_for hands out a contiguous slice of the task indices to each
+// worker. A worker runs its own slice from the front, and once it runs
+// out it steals from the back of somebody else's slice, so uneven work
+// gets balanced without any central queue.
+class WorkStealingPool {
+public:
+  struct ThreadStats {
+    std::size_t tasks = 0;
+    std::size_t steals = 0;
+    std::chrono::nanoseconds busy{};
+  };
+
+  explicit WorkStealingPool(
+      std::size_t thread_count = std::thread::hardware_concurrency(),
+      bool pin_threads = false) {
+    thread_count = std::max<std::size_t>(thread_count, 1);
+
+    for (std::size_t index = 0; index < thread_count; ++index) {
+      m_workers.push_back(std::make_unique<Worker>());
+    }
+    for (std::size_t index = 0; index < thread_count; ++index) {
+      m_threads.emplace_back([this, index] { worker_loop(index); });
+      if (pin_threads) {
+        pin_to_cpu(m_threads.back(), index);
+      }
+    }
+  }
+
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+  ~WorkStealingPool() {
+    {
+      std::scoped_lock lock(m_mutex);
+      m_stopping = true;
+    }
+    m_start.notify_all();
+    for (auto &thread : m_threads) {
+      thread.join();
+    }
+  }
+
+  // Calls task(0) ... task(count - 1) on the pool, returns when all
+  // of them are done
+  void parallel_for(std::size_t count,
+                    const std::function<void(std::size_t)> &task) {
+    if (count == 0) {
+      return;
+    }
+
+    std::unique_lock lock(m_mutex);
+    m_task = &task;
+    m_remaining = count;
+
+    const auto thread_count = m_workers.size();
+    for (std::size_t index = 0; index < thread_count; ++index) {
+      auto &worker = *m_workers[index];
+      std::scoped_lock worker_lock(worker.mutex);
+      for (auto task_index = index * count / thread_count;
+           task_index < (index + 1) * count / thread_count; ++task_index) {
+        worker.tasks.push_back(task_index);
+      }
+    }
+
+    ++m_generation;
+    m_start.notify_all();
+
+    // also wait for the workers to get out of run_tasks, so that their
+    // stats are complete
+    m_done.wait(lock, [&] { return m_remaining == 0 && m_active == 0; });
+  }
+
+  [[nodiscard]] std::size_t thread_count() const { return m_workers.size(); }
+
+  [[nodiscard]] std::vector<ThreadStats> stats() const {
+    std::vector<ThreadStats> result;
+    for (const auto &worker : m_workers) {
+      std::scoped_lock lock(worker->mutex);
+      result.push_back(worker->stats);
+    }
+    return result;
+  }
+
+private:
+  struct Worker {
+    mutable std::mutex mutex;
+    std::deque<std::size_t> tasks;
+    ThreadStats stats;
+  };
+
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  std::vector<std::thread> m_threads;
+
+  std::mutex m_mutex;
+  std::condition_variable m_start;
+  std::condition_variable m_done;
+  std::size_t m_generation = 0;
+  std::size_t m_remaining = 0;
+  std::size_t m_active = 0;
+  bool m_stopping = false;
+  const std::function<void(std::size_t)> *m_task = nullptr;
+
+  [[nodiscard]] std::optional<std::size_t> pop_own(std::size_t index) {
+    auto &worker = *m_workers[index];
+    std::scoped_lock lock(worker.mutex);
+    if (worker.tasks.empty()) {
+      return std::nullopt;
+    }
+    const auto task = worker.tasks.front();
+    worker.tasks.pop_front();
+    return task;
+  }
+
+  [[nodiscard]] std::optional<std::size_t> steal(std::size_t index) {
+    // start with the neighbor, so that not everyone piles onto worker 0
+    for (std::size_t offset = 1; offset < m_workers.size(); ++offset) {
+      auto &victim = *m_workers[(index + offset) % m_workers.size()];
+      std::scoped_lock lock(victim.mutex);
+      if (!victim.tasks.empty()) {
+        const auto task = victim.tasks.back();
+        victim.tasks.pop_back();
+        return task;
+      }
+    }
+    return std::nullopt;
+  }
+
+  void run_tasks(std::size_t index) {
+    ThreadStats stats;
+    const auto start = std::chrono::steady_clock::now();
+
+    while (true) {
+      auto task = pop_own(index);
+      if (!task) {
+        task = steal(index);
+        if (!task) {
+          break;
+        }
+        ++stats.steals;
+      }
+
+      (*m_task)(*task);
+      ++stats.tasks;
+
+      std::scoped_lock lock(m_mutex);
+      if (--m_remaining == 0) {
+        m_done.notify_all();
+      }
+    }
+
+    auto &worker = *m_workers[index];
+    {
+      std::scoped_lock lock(worker.mutex);
+      worker.stats.tasks += stats.tasks;
+      worker.stats.steals += stats.steals;
+      worker.stats.busy += std::chrono::steady_clock::now() - start;
+    }
+
+    std::scoped_lock lock(m_mutex);
+    if (--m_active == 0) {
+      m_done.notify_all();
+    }
+  }
+
+  void worker_loop(std::size_t index) {
+    std::size_t seen_generation = 0;
+    while (true) {
+      {
+        std::unique_lock lock(m_mutex);
+        m_start.wait(lock, [&] {
+          return m_stopping || m_generation != seen_generation;
+        });
+        if (m_stopping) {
+          return;
+        }
+        seen_generation = m_generation;
+        ++m_active;
+      }
+      run_tasks(index);
+    }
+  }
+};
+
+#endif
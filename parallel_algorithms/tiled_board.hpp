@@ -0,0 +1,202 @@
+#ifndef CPP_WEEKLY_TILED_BOARD_HPP
+#define CPP_WEEKLY_TILED_BOARD_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <execution>
+
+#include "life_rule.hpp"
+
+// Cache blocked stepping for byte-per-cell boards (GameBoard).
+//
+// Instead of handing every Point on the board to std::transform, the board
+// is cut into bands of whole rows that fit in L2. Each band is one unit of
+// parallel work and walks its rows top to bottom, so the row above / below
+// are still in cache when they get reused. Wraparound is only computed once
+// per row (the row pointers) and for the first / last column; everything
+// in between is plain pointer arithmetic with no modulo.
+
+// The amount of cache we are trying to stay inside of per band, override
+// with -DGOL_L2_CACHE_BYTES=... to match your CPU
+#ifndef GOL_L2_CACHE_BYTES
+#define GOL_L2_CACHE_BYTES (256 * 1024)
+#endif
+
+// Computes result[first, last) from the 3 input rows around it, with no
+// wraparound: the caller guarantees that [first - 1, last + 1) is readable.
+// This is the innermost loop, it has no branches, so the compiler is free
+// to vectorize it.
+//
+// `rule` is any of the rules from life_rule.hpp, Conway by default.
+template <typename Cell, typename Rule = ConwayRule>
+constexpr void iterate_dense_span(const Cell *above, const Cell *middle,
+                                  const Cell *below, Cell *result,
+                                  std::size_t first, std::size_t last,
+                                  const Rule &rule = {}) {
+  for (std::size_t x = first; x < last; ++x) {
+    const auto neighbors = static_cast<unsigned>(
+        above[x - 1] + above[x] + above[x + 1] + middle[x - 1] +
+        middle[x + 1] + below[x - 1] + below[x] + below[x + 1]);
+    result[x] = rule(middle[x], neighbors);
+  }
+}
+
+// Computes result[first, last) of a row from the 3 input rows around it,
+// wrapping around horizontally when the range touches either edge
+template <typename Cell, typename Rule = ConwayRule>
+constexpr void iterate_dense_row_range(const Cell *above, const Cell *middle,
+                                       const Cell *below, Cell *result,
+                                       std::size_t width, std::size_t first,
+                                       std::size_t last,
+                                       const Rule &rule = {}) {
+  const auto count = [&](std::size_t west, std::size_t x, std::size_t east) {
+    return static_cast<unsigned>(above[west] + above[x] + above[east] +
+                                 middle[west] + middle[east] + below[west] +
+                                 below[x] + below[east]);
+  };
+
+  if (width == 1) {
+    result[0] = rule(middle[0], count(0, 0, 0));
+    return;
+  }
+
+  // the only two columns that wrap around
+  if (first == 0) {
+    result[0] = rule(middle[0], count(width - 1, 0, 1));
+    first = 1;
+  }
+  if (last == width) {
+    result[width - 1] =
+        rule(middle[width - 1], count(width - 2, width - 1, 0));
+    last = width - 1;
+  }
+
+  iterate_dense_span(above, middle, below, result, first, last, rule);
+}
+
+// Computes one output row from the 3 input rows around it
+template <typename Cell, typename Rule = ConwayRule>
+constexpr void iterate_dense_row(const Cell *above, const Cell *middle,
+                                 const Cell *below, Cell *result,
+                                 std::size_t width, const Rule &rule = {}) {
+  iterate_dense_row_range(above, middle, below, result, width, 0, width,
+                          rule);
+}
+
+template <typename BoardType> struct TileBands {
+  using cell_type = typename decltype(BoardType::data)::value_type;
+
+  static constexpr auto width = static_cast<std::size_t>(BoardType::width);
+  static constexpr auto height = static_cast<std::size_t>(BoardType::height);
+
+  // input and output rows both need to be resident
+  static constexpr std::size_t band_height = std::clamp<std::size_t>(
+      GOL_L2_CACHE_BYTES / (2 * width * sizeof(cell_type)), 1,
+      height);
+
+  static constexpr std::size_t count =
+      (height + band_height - 1) / band_height;
+
+  // first row of each band, this is all the "index" data we need
+  static constexpr auto first_rows = [] {
+    std::array<std::uint32_t, count> result{};
+    for (std::size_t band = 0; band < count; ++band) {
+      result[band] = static_cast<std::uint32_t>(band * band_height);
+    }
+    return result;
+  }();
+};
+
+// The default way of computing a row, leaves vectorization up to the
+// compiler
+template <typename Rule = ConwayRule> struct DenseRowKernel {
+  Rule rule{};
+
+  template <typename Cell>
+  constexpr void operator()(const Cell *above, const Cell *middle,
+                            const Cell *below, Cell *result,
+                            std::size_t width) const {
+    iterate_dense_row(above, middle, below, result, width, rule);
+  }
+};
+
+// Steps rows [first_row, last_row) of the board
+template <typename BoardType, typename RowKernel = DenseRowKernel<>>
+constexpr void iterate_rows(const BoardType &input, BoardType &output,
+                            std::size_t first_row, std::size_t last_row,
+                            const RowKernel &row_kernel = {}) {
+  constexpr auto width = TileBands<BoardType>::width;
+  constexpr auto height = TileBands<BoardType>::height;
+
+  const auto row = [](auto &board, std::size_t y) {
+    return board.data.data() + y * width;
+  };
+
+  for (std::size_t y = first_row; y < last_row; ++y) {
+    // vertical wraparound only ever happens on the edge bands
+    const auto above = y == 0 ? height - 1 : y - 1;
+    const auto below = y == height - 1 ? 0 : y + 1;
+
+    row_kernel(row(input, above), row(input, y), row(input, below),
+               row(output, y), width);
+  }
+}
+
+template <typename BoardType, typename RowKernel = DenseRowKernel<>>
+constexpr void iterate_board_tiled(const BoardType &input, BoardType &output,
+                                   const RowKernel &row_kernel = {}) {
+  using bands = TileBands<BoardType>;
+
+  const auto step_band = [&](const auto first_row) {
+    iterate_rows(input, output, first_row,
+                 std::min(first_row + bands::band_height, bands::height),
+                 row_kernel);
+  };
+
+#ifndef SERIAL
+  if consteval {
+#endif
+    std::for_each(bands::first_rows.begin(), bands::first_rows.end(),
+                  step_band);
+#ifndef SERIAL
+  } else {
+    std::for_each(std::execution::par_unseq, bands::first_rows.begin(),
+                  bands::first_rows.end(), step_band);
+  }
+#endif
+}
+
+// Tiled stepping for any rule chosen at runtime. Rules in known_rules get a
+// kernel compiled just for them, everything else goes through the runtime
+// table. Picked once, so stepping is just a call through the pointer.
+template <typename BoardType>
+using rule_stepper = void (*)(const BoardType &, BoardType &, LifeRule);
+
+template <typename BoardType, std::size_t Index = 0>
+[[nodiscard]] constexpr rule_stepper<BoardType> select_rule_stepper(LifeRule rule) {
+  if constexpr (Index < known_rules.size()) {
+    if (rule == known_rules[Index].rule) {
+      return [](const BoardType &input, BoardType &output, LifeRule) {
+        iterate_board_tiled(
+            input, output,
+            DenseRowKernel<StaticRule<known_rules[Index].rule>>{});
+      };
+    }
+    return select_rule_stepper<BoardType, Index + 1>(rule);
+  } else {
+    return [](const BoardType &input, BoardType &output, LifeRule runtime_rule) {
+      iterate_board_tiled(input, output,
+                          DenseRowKernel<DynamicRule>{{runtime_rule}});
+    };
+  }
+}
+
+[[nodiscard]] constexpr bool is_known_rule(LifeRule rule) {
+  return std::ranges::any_of(known_rules, [&](const auto &known) {
+    return known.rule == rule;
+  });
+}
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef CPP_WEEKLY_WARM_START_HPP
+#define CPP_WEEKLY_WARM_START_HPP
+
+#include <algorithm>
+#include <cstddef>
+
+#include "game_board.hpp"
+#include "life_rule.hpp"
+#include "lookup_board.hpp"
+#include "tiled_board.hpp"
+
+// Runs the first generations of a fixed starting pattern while compiling,
+// so a run that always starts the same way begins from a board that is
+// already embedded in the binary, and the startup transient costs nothing
+// at runtime.
+//
+// Compile time evaluation is slow, and compilers cap it (see gcc's
+// -fconstexpr-ops-limit and clang's -fconstexpr-steps), so
+// -DGOL_CONSTEXPR_BUDGET=<cell updates> sets how much is done while
+// compiling. Whatever doesn't fit is left for runtime. The default of 0
+// turns warm starts off entirely. With gcc, 100000 adds about 2 seconds of
+// compile time per distinct board, and somewhere past 200000 the default
+// -fconstexpr-ops-limit has to be raised too.
+#ifndef GOL_CONSTEXPR_BUDGET
+#define GOL_CONSTEXPR_BUDGET 0
+#endif
+
+// How many of the first `generations` of a WidthxHeight board fit in the
+// budget
+template <std::size_t Width, std::size_t Height, std::size_t Generations>
+inline constexpr std::size_t warm_start_generations =
+    std::min<std::size_t>(Generations,
+                          std::size_t{GOL_CONSTEXPR_BUDGET} / (Width * Height));
+
+template <std::size_t Width, std::size_t Height> struct WarmStart {
+  GameBoard<Width, Height> board;
+  // how far along board is
+  std::size_t generations;
+};
+
+// setup(board) draws the starting pattern on an empty board, then as many
+// generations as the budget allows are run, all during compilation
+template <std::size_t Width, std::size_t Height, std::size_t Generations,
+          LifeRule Rule = conway_rule>
+[[nodiscard]] consteval WarmStart<Width, Height> warm_start(auto setup) {
+  constexpr auto generations =
+      warm_start_generations<Width, Height, Generations>;
+
+  WarmStart<Width, Height> result{{}, generations};
+  GameBoard<Width, Height> scratch{};
+  setup(result.board);
+
+  // the lookup table is the fewest operations per cell, which is what
+  // counts for the constexpr evaluator
+  for (std::size_t generation = 0; generation < generations; ++generation) {
+    if (generation % 2 == 0) {
+      iterate_board_tiled(result.board, scratch, LookupRowKernel<Rule>{});
+    } else {
+      iterate_board_tiled(scratch, result.board, LookupRowKernel<Rule>{});
+    }
+  }
+  if (generations % 2 == 1) {
+    result.board = scratch;
+  }
+
+  return result;
+}
+
+// Copies a warm start into any board type
+template <typename BoardType, std::size_t Width, std::size_t Height>
+constexpr void load_warm_start(BoardType &board,
+                               const GameBoard<Width, Height> &warm) {
+  if constexpr (requires { board.load(warm); }) {
+    board.load(warm);
+  } else {
+    board.data = warm.data;
+  }
+}
+
+#endif
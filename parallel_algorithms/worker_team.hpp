@@ -0,0 +1,132 @@
+#ifndef CPP_WEEKLY_WORKER_TEAM_HPP
+#define CPP_WEEKLY_WORKER_TEAM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+// Busy-waits instead of going to sleep in the kernel. Every generation of
+// a 10x10 board is only a few hundred nanoseconds of work, so waking
+// threads up through a condition variable (or forking them through
+// std::execution::par) costs far more than the work itself.
+class SpinBarrier {
+public:
+  explicit SpinBarrier(std::size_t count)
+      : m_count(count),
+        // with more threads than cores, whoever we are waiting for might
+        // need our core, so don't spin at all
+        m_spin_limit(count <= std::thread::hardware_concurrency() ? 1 << 14
+                                                                  : 0) {}
+
+  void arrive_and_wait() {
+    const auto phase = m_phase.load(std::memory_order_relaxed);
+
+    if (m_waiting.fetch_add(1, std::memory_order_acq_rel) + 1 == m_count) {
+      // last one in resets the count and releases everybody else
+      m_waiting.store(0, std::memory_order_relaxed);
+      m_phase.store(phase + 1, std::memory_order_release);
+      return;
+    }
+
+    // after a while back off a bit, so a long pause between generations
+    // does not completely starve everything else
+    for (std::size_t spins = 0;
+         m_phase.load(std::memory_order_acquire) == phase; ++spins) {
+      if (spins < m_spin_limit) {
+        cpu_relax();
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+private:
+  static void cpu_relax() {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_ia32_pause();
+#endif
+  }
+
+  std::size_t m_count;
+  std::size_t m_spin_limit;
+  // on separate cache lines, everyone hammers m_phase while spinning
+  alignas(64) std::atomic<std::size_t> m_waiting{0};
+  alignas(64) std::atomic<std::size_t> m_phase{0};
+};
+
+// A fixed team of threads that stays alive for as long as the team does.
+//
+// run(func) calls func(0) ... func(size() - 1), one per team member, and
+// returns when all of them are done. The calling thread is member 0 and does
+// its share of the work too. Member i is always the same thread, so work that
+// is split up the same way every time always lands on the same thread
+// (and the same cache).
+class WorkerTeam {
+public:
+  explicit WorkerTeam(
+      std::size_t thread_count = std::thread::hardware_concurrency(),
+      bool pin_threads = false)
+      : m_size(std::max<std::size_t>(thread_count, 1)), m_start(m_size),
+        m_finish(m_size) {
+    for (std::size_t index = 1; index < m_size; ++index) {
+      m_threads.emplace_back([this, index] { worker_loop(index); });
+      if (pin_threads) {
+        pin_to_cpu(m_threads.back(), index);
+      }
+    }
+  }
+
+  WorkerTeam(const WorkerTeam &) = delete;
+  WorkerTeam &operator=(const WorkerTeam &) = delete;
+
+  ~WorkerTeam() {
+    m_stopping = true;
+    m_start.arrive_and_wait();
+    for (auto &thread : m_threads) {
+      thread.join();
+    }
+  }
+
+  [[nodiscard]] std::size_t size() const { return m_size; }
+
+  template <typename Func> void run(const Func &func) {
+    // no std::function here, this is called once per generation
+    m_job = [](const void *context, std::size_t index) {
+      (*static_cast<const Func *>(context))(index);
+    };
+    m_context = &func;
+
+    // the barriers are what publish m_job and m_context to the workers
+    m_start.arrive_and_wait();
+    func(0);
+    m_finish.arrive_and_wait();
+  }
+
+private:
+  std::size_t m_size;
+  SpinBarrier m_start;
+  SpinBarrier m_finish;
+  std::vector<std::thread> m_threads;
+
+  bool m_stopping = false;
+  void (*m_job)(const void *, std::size_t) = nullptr;
+  const void *m_context = nullptr;
+
+  void worker_loop(std::size_t index) {
+    while (true) {
+      m_start.arrive_and_wait();
+      if (m_stopping) {
+        return;
+      }
+      m_job(m_context, index);
+      m_finish.arrive_and_wait();
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,45 @@
+import cppyy
+import numpy
+import pygame
+
+cppyy.include("cellular_automata.hpp")
+
+RuleKind = cppyy.gbl.RuleKind
+
+width = 320
+height = 240
+
+obj = cppyy.gbl.CellularAutomata(
+    width, height, cppyy.gbl.std.vector[RuleKind]([RuleKind.fire])
+)
+
+obj.randomize_values(0, 255)
+
+# Top and bottom borders
+for x in range(0, obj.width):
+    obj.set(x, 0, 0, 0, 0, 0)
+    obj.set(x, obj.height - 1, 0, 255, 10, -10)
+
+# Left and right borders
+for y in range(0, obj.height):
+    obj.set(0, y, 0, 0, 0, 0)
+    obj.set(obj.width - 1, y, 0, 0, 0, 0)
+
+for y in range(obj.height - 300, obj.height):
+    obj.set(obj.width - 1, y, 0, 0, -10, 0)
+
+# the values as a numpy array, straight out of the C++ object, no copies
+values = obj.values()
+values.reshape((width * height,))
+values = numpy.frombuffer(values, dtype=numpy.int32).reshape(height, width)
+
+pygame.init()
+screen = pygame.display.set_mode((width, height))
+
+while True:
+    # surfarray is indexed [x][y], with one channel per color
+    gray = numpy.clip(values.T, 0, 255).astype(numpy.uint8)
+    pygame.surfarray.blit_array(screen, numpy.dstack((gray, gray, gray)))
+
+    pygame.display.flip()
+    obj.step(1, True)
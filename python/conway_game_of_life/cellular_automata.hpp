@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+// Native version of the model in cellular_automata.py, meant to be driven
+// from Python through cppyy (see cellular_automata-cppyy.py).
+//
+// The Python version keeps a list of Cell objects and calls the rule of
+// every cell through a new Neighborhood object, every generation. Here the
+// cells are a structure of arrays (one array per field of Cell), and the
+// cells are grouped by their rule_number, so every rule runs as one tight,
+// branch free loop over just its own cells, no matter how many different
+// rules are mixed on the board.
+
+// The rules from cellular_automata.py, rules[rule_number] picks one per cell
+enum class RuleKind : std::uint8_t { gravity, fire };
+
+struct CellularAutomata
+{
+  using index_t = std::make_signed_t<std::size_t>;
+
+  std::size_t width;
+  std::size_t height;
+  std::vector<RuleKind> rules;
+
+  // cell i of the board is element i of each of these
+  std::vector<std::uint8_t> rule_number = std::vector<std::uint8_t>(width * height);
+  std::vector<std::int32_t> value = std::vector<std::int32_t>(width * height);
+  std::vector<float> velocity_x = std::vector<float>(width * height);
+  std::vector<float> velocity_y = std::vector<float>(width * height);
+
+  // the generation being computed, swapped with the above by step(). The
+  // rules only move values around, never cells between rules, so there is
+  // no next_rule_number.
+  std::vector<std::int32_t> next_value = std::vector<std::int32_t>(width * height);
+  std::vector<float> next_velocity_x = std::vector<float>(width * height);
+  std::vector<float> next_velocity_y = std::vector<float>(width * height);
+
+  // The indexes of the cells, grouped by rule by partition(). The cells of
+  // rule r are buckets[2r] .. buckets[2r + 2] of order, the ones that are
+  // not on the edge of the board (and so never need to wrap) first, and the
+  // edge ones from buckets[2r + 1].
+  std::vector<std::uint32_t> order = std::vector<std::uint32_t>(width * height);
+  std::vector<std::size_t> buckets;
+  bool partition_valid = false;
+  bool partition_skip_borders = false;
+
+  // seeds the per cell random numbers, so every generation gets new ones
+  std::uint64_t generation = 0;
+
+  CellularAutomata(std::size_t width_, std::size_t height_, const std::vector<RuleKind> &rules_)
+    : width(width_), height(height_), rules(rules_) {}
+
+  [[nodiscard]] std::size_t index(index_t x, index_t y) const
+  {
+    const auto w = static_cast<index_t>(width);
+    const auto h = static_cast<index_t>(height);
+    return static_cast<std::size_t>((((y % h) + h) % h) * w + (((x % w) + w) % w));
+  }
+
+  // the only thing that changes rule_number, and so the partition
+  void set_rule(index_t x, index_t y, std::uint8_t rule)
+  {
+    const auto cell = index(x, y);
+    if (rule_number[cell] != rule) {
+      rule_number[cell] = rule;
+      partition_valid = false;
+    }
+  }
+
+  void set(index_t x, index_t y, std::uint8_t rule, std::int32_t value_, float velocity_x_, float velocity_y_)
+  {
+    set_rule(x, y, rule);
+    const auto cell = index(x, y);
+    value[cell] = value_;
+    velocity_x[cell] = velocity_x_;
+    velocity_y[cell] = velocity_y_;
+  }
+
+  [[nodiscard]] std::int32_t get_value(index_t x, index_t y) const { return value[index(x, y)]; }
+
+  // width * height values, row by row, for viewing from Python without a copy
+  // (see cellular_automata-cppyy.py). Stays valid across step().
+  [[nodiscard]] std::int32_t *values() { return value.data(); }
+
+  void randomize_values(std::int32_t value_min, std::int32_t value_max, std::uint32_t seed = std::random_device{}())
+  {
+    std::mt19937 engine{ seed };
+    std::uniform_int_distribution<std::int32_t> distribution{ value_min, value_max };
+    std::generate(value.begin(), value.end(), [&] { return distribution(engine); });
+    std::fill(velocity_x.begin(), velocity_x.end(), 0.0f);
+    std::fill(velocity_y.begin(), velocity_y.end(), 0.0f);
+  }
+
+  // Advances n generations in place. With skip_borders the outermost cells
+  // are left as they are, like Automata.next(skip_borders=True).
+  void step(std::size_t n = 1, bool skip_borders = false)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      if (!partition_valid || partition_skip_borders != skip_borders) {
+        partition(skip_borders);
+      }
+
+      // every rule writes all fields of all of its cells, the cells that no
+      // rule runs on (the skipped borders) are the only ones to copy over
+      keep_unruled_cells();
+      for (std::size_t rule = 0; rule < rules.size(); ++rule) {
+        run_rule(rule);
+      }
+
+      swap_buffers();
+      ++generation;
+    }
+
+    // keep the results in the buffers that values() handed out
+    if (n % 2 == 1) {
+      swap_buffers();
+      value = next_value;
+      velocity_x = next_velocity_x;
+      velocity_y = next_velocity_y;
+    }
+  }
+
+  void swap_buffers()
+  {
+    value.swap(next_value);
+    velocity_x.swap(next_velocity_x);
+    velocity_y.swap(next_velocity_y);
+  }
+
+  // Counting sort of the cell indexes by (rule, is on the edge), two passes
+  // over rule_number and no allocations after the first time
+  void partition(bool skip_borders)
+  {
+    const auto is_edge = [&](std::size_t x, std::size_t y) {
+      return x == 0 || y == 0 || x == width - 1 || y == height - 1;
+    };
+    // cells that are skipped, or have no rule, go in a last bucket nobody runs
+    const auto bucket_of = [&](std::size_t x, std::size_t y) {
+      const auto rule = rule_number[y * width + x];
+      if ((skip_borders && is_edge(x, y)) || rule >= rules.size()) {
+        return 2 * rules.size();
+      }
+      return 2 * std::size_t{ rule } + (is_edge(x, y) ? 1 : 0);
+    };
+
+    buckets.assign(2 * rules.size() + 2, 0);
+    for (std::size_t y = 0; y < height; ++y) {
+      for (std::size_t x = 0; x < width; ++x) {
+        ++buckets[bucket_of(x, y) + 1];
+      }
+    }
+    std::partial_sum(buckets.begin(), buckets.end(), buckets.begin());
+
+    auto next = buckets;
+    for (std::size_t y = 0; y < height; ++y) {
+      for (std::size_t x = 0; x < width; ++x) {
+        order[next[bucket_of(x, y)]++] = static_cast<std::uint32_t>(y * width + x);
+      }
+    }
+
+    partition_valid = true;
+    partition_skip_borders = skip_borders;
+  }
+
+  // the last bucket of partition()
+  void keep_unruled_cells()
+  {
+    const auto *begin = order.data() + buckets[2 * rules.size()];
+    const auto *end = order.data() + buckets[2 * rules.size() + 1];
+    for (const auto *it = begin; it != end; ++it) {
+      const auto cell = *it;
+      next_value[cell] = value[cell];
+      next_velocity_x[cell] = velocity_x[cell];
+      next_velocity_y[cell] = velocity_y[cell];
+    }
+  }
+
+  void run_rule(std::size_t rule)
+  {
+    const auto *interior_begin = order.data() + buckets[2 * rule];
+    const auto *edge_begin = order.data() + buckets[2 * rule + 1];
+    const auto *edge_end = order.data() + buckets[2 * rule + 2];
+
+    // away from the edges the neighbors are just a fixed offset away
+    const auto w = static_cast<index_t>(width);
+    const auto interior = [w](std::size_t cell, index_t dx, index_t dy) {
+      return static_cast<std::size_t>(static_cast<index_t>(cell) + dy * w + dx);
+    };
+    const auto wrapping = [this](std::size_t cell, index_t dx, index_t dy) { return neighbor(cell, dx, dy); };
+
+    switch (rules[rule]) {
+    case RuleKind::gravity:
+      gravity(interior_begin, edge_begin, interior);
+      gravity(edge_begin, edge_end, wrapping);
+      break;
+    case RuleKind::fire:
+      fire(interior_begin, edge_begin, interior);
+      fire(edge_begin, edge_end, wrapping);
+      break;
+    }
+  }
+
+  [[nodiscard]] std::size_t neighbor(std::size_t cell, index_t dx, index_t dy) const
+  {
+    return index(static_cast<index_t>(cell % width) + dx, static_cast<index_t>(cell / width) + dy);
+  }
+
+  // random.random() stand in, the same cell, generation and draw always give
+  // the same number, no matter which order the cells are computed in
+  [[nodiscard]] float random(std::size_t cell, std::uint64_t draw) const
+  {
+    // splitmix64
+    auto state = (generation * width * height + cell) * 32 + draw + 0x9E3779B97F4A7C15ULL;
+    state = (state ^ (state >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    state = (state ^ (state >> 27)) * 0x94D049BB133111EBULL;
+    state ^= state >> 31;
+    return static_cast<float>(state >> 40) / static_cast<float>(1 << 24);
+  }
+
+  // Things fall down, one cell per generation. A cell can only either fill
+  // or empty, so this is the current value plus or minus one.
+  template<typename Neighbors>
+  void gravity(const std::uint32_t *begin, const std::uint32_t *end, Neighbors neighbors)
+  {
+    for (const auto *it = begin; it != end; ++it) {
+      const auto cell = *it;
+      const auto current = value[cell];
+      const auto fills = (current == 0) & (value[neighbors(cell, 0, -1)] == 1);
+      const auto empties = (current == 1) & (value[neighbors(cell, 0, 1)] == 0);
+      next_value[cell] = current + std::int32_t{ fills } - std::int32_t{ empties };
+      next_velocity_x[cell] = velocity_x[cell];
+      next_velocity_y[cell] = velocity_y[cell];
+    }
+  }
+
+  // is the neighbor at offset (dx, dy) moving towards the center cell?
+  [[nodiscard]] static bool towards_me(index_t dx, index_t dy, float velocity_x_, float velocity_y_)
+  {
+    const auto opposes = [](index_t offset, float velocity) {
+      return ((offset < 0) & (velocity > 0)) | ((offset == 0) & (velocity == 0)) | ((offset > 0) & (velocity < 0));
+    };
+    return opposes(dx, velocity_x_) & opposes(dy, velocity_y_);
+  }
+
+  // Every neighbor is always looked at, the ones that are not moving towards
+  // this cell just add 0, so there is nothing to branch on. Each neighbor
+  // gets its own 3 random draws either way.
+  template<typename Neighbors>
+  void fire(const std::uint32_t *begin, const std::uint32_t *end, Neighbors neighbors)
+  {
+    constexpr float falloff = .99f;
+
+    for (const auto *it = begin; it != end; ++it) {
+      const auto cell = *it;
+      std::uint64_t draw = 0;
+      auto new_value = static_cast<std::int32_t>(static_cast<float>(value[cell]) * (random(cell, draw++) * falloff));
+      auto new_velocity_x = velocity_x[cell];
+      auto new_velocity_y = velocity_y[cell];
+
+      for (index_t dx = -1; dx <= 1; ++dx) {
+        for (index_t dy = -1; dy <= 1; ++dy) {
+          if (dx == 0 && dy == 0) {
+            continue;
+          }
+          const auto other = neighbors(cell, dx, dy);
+          const auto weight = towards_me(dx, dy, velocity_x[other], velocity_y[other]) ? falloff : 0.0f;
+          new_value += static_cast<std::int32_t>(static_cast<float>(value[other]) * (random(cell, draw++) * weight));
+          new_velocity_x += velocity_x[other] * (random(cell, draw++) * weight);
+          new_velocity_y += velocity_y[other] * (random(cell, draw++) * weight);
+        }
+      }
+
+      next_value[cell] = std::min(new_value, 255);
+      next_velocity_x[cell] = new_velocity_x;
+      next_velocity_y[cell] = new_velocity_y;
+    }
+  }
+};
@@ -1,5 +1,7 @@
 #include <algorithm>
 #include <array>
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <type_traits>
 #include <vector>
@@ -20,7 +22,13 @@ struct Automata
   std::array<bool, 9> born;
   std::array<bool, 9> survives;
 
-  std::vector<bool> data = std::vector<bool>(width * height);
+  // One byte (0 or 1) per cell, row by row. Not std::vector<bool>, so that
+  // Python can look straight at the cells, see cells() and load().
+  std::vector<std::uint8_t> data = std::vector<std::uint8_t>(width * height);
+
+  // step() computes the next generation into here and swaps it with data,
+  // so it never allocates
+  std::vector<std::uint8_t> next_data = std::vector<std::uint8_t>(width * height);
 
   Automata(std::size_t width_, std::size_t height_, std::array<bool, 9> born_, std::array<bool, 9> survives_)
     : width(width_), height(height_), born(born_), survives(survives_) {}
@@ -49,9 +57,32 @@ struct Automata
     return floor_modulo(p.y, static_cast<index_t>(height)) * width + floor_modulo(p.x, static_cast<index_t>(width));
   }
 
-  [[nodiscard]] bool get(Point p) const { return data[index(p)]; }
+  [[nodiscard]] bool get(Point p) const { return data[index(p)] != 0; }
+
+  void set(Point p) { data[index(p)] = 1; }
+
+  // The cells, width * height bytes, row by row. From Python this can be
+  // wrapped without copying anything:
+  //
+  //   cells = obj.cells()
+  //   cells.reshape((obj.width * obj.height,))
+  //   numpy.frombuffer(cells, dtype=numpy.uint8).reshape(obj.height, obj.width)
+  //
+  // The pointer stays valid (and keeps showing the current generation) for as
+  // long as the Automata is alive, step() always leaves its result here.
+  [[nodiscard]] std::uint8_t *cells() { return data.data(); }
 
-  void set(Point p) { data[index(p)] = true; }
+  [[nodiscard]] std::size_t cell_count() const { return data.size(); }
+
+  // Replaces every cell from a buffer of width * height bytes (anything
+  // non-zero is alive), any Python buffer (bytes, bytearray, numpy array)
+  // can be passed in directly
+  void load(const std::uint8_t *buffer, std::size_t size)
+  {
+    const auto count = std::min(size, data.size());
+    std::transform(buffer, buffer + count, data.begin(), [](std::uint8_t cell) { return static_cast<std::uint8_t>(cell != 0); });
+    std::fill(data.begin() + static_cast<std::ptrdiff_t>(count), data.end(), std::uint8_t{ 0 });
+  }
 
   constexpr static std::array<Point, 8> neighbors{
     Point{ -1, -1 },
@@ -70,6 +101,16 @@ struct Automata
       std::count_if(neighbors.begin(), neighbors.end(), [&](auto offset) { return get(p + offset); }));
   }
 
+  [[nodiscard]] bool next_alive(Point p) const
+  {
+    const auto neighbors = count_neighbors(p);
+    if (get(p)) {
+      return survives[neighbors];
+    } else {
+      return born[neighbors];
+    }
+  }
+
   [[nodiscard]] Automata next() const
   {
     Automata result{ width, height, born, survives };
@@ -77,21 +118,35 @@ struct Automata
     for (std::size_t y = 0; y < height; ++y) {
       for (std::size_t x = 0; x < width; ++x) {
         Point p{ static_cast<index_t>(x), static_cast<index_t>(y) };
-        const auto neighbors = count_neighbors(p);
-        if (get(p)) {
-          if (survives[neighbors]) {
-            result.set(p);
-          }
-        } else {
-          if (born[neighbors]) {
-            result.set(p);
-          }
+        if (next_alive(p)) {
+          result.set(p);
         }
       }
     }
 
     return result;
   }
+
+  // Advances n generations in place, ping-ponging between data and next_data.
+  // Nothing is allocated, and from Python this is one call per batch of
+  // generations instead of one call (and one new Automata) per generation.
+  void step(std::size_t n = 1)
+  {
+    for (std::size_t generation = 0; generation < n; ++generation) {
+      for (std::size_t y = 0; y < height; ++y) {
+        for (std::size_t x = 0; x < width; ++x) {
+          next_data[y * width + x] = next_alive(Point{ static_cast<index_t>(x), static_cast<index_t>(y) });
+        }
+      }
+      data.swap(next_data);
+    }
+
+    // keep the result in the same buffer that cells() handed out
+    if (n % 2 == 1) {
+      data.swap(next_data);
+      std::copy(next_data.begin(), next_data.end(), data.begin());
+    }
+  }
   void add_glider(Point p)
   {
     set(p);
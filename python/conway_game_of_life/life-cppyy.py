@@ -14,14 +14,16 @@ obj = cppyy.gbl.Automata(40, 20, born, survives)
 
 obj.add_glider(cppyy.gbl.Automata.Point(0, 18))
 
-for i in range(10000):
-    obj = obj.next()
+# all 10000 generations in one call, in place, instead of crossing into C++
+# (and getting a brand new Automata back) once per generation
+obj.step(10000)
 
 
+# a view straight onto the C++ cells, instead of one get() call per cell
+cells = obj.cells()
+cells.reshape((obj.cell_count(),))
+cells = memoryview(cells)
+
 for y in range(obj.height):
-    for x in range(obj.width):
-        if obj.get(cppyy.gbl.Automata.Point(x, y)):
-            print("X", end="")
-        else:
-            print(".", end="")
-    print()
+    row = cells[y * obj.width : (y + 1) * obj.width]
+    print("".join("X" if cell else "." for cell in row))
@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <array>
+#include <cstdint>
 #include <cstdio>
 #include <type_traits>
 #include <vector>
@@ -22,7 +23,28 @@ struct Automata
   std::array<bool, 9> born;
   std::array<bool, 9> survives;
 
-  std::vector<bool> data = std::vector<bool>(width * height);
+  // One byte (0 or 1) per cell, not std::vector<bool>, so step() can walk
+  // the rows with plain pointers
+  std::vector<std::uint8_t> data = std::vector<std::uint8_t>(width * height);
+
+  // step() computes the next generation into here and swaps it with data,
+  // so it never allocates
+  std::vector<std::uint8_t> next_data = std::vector<std::uint8_t>(width * height);
+
+  // Only used by step_incremental(): the live neighbor count of every cell,
+  // and the cells that flipped in the last generation. A cell whose state
+  // and neighbor count did not change, and that did not flip last time,
+  // can't flip this time either, so only the flipped cells and their
+  // neighbors ever need to be looked at.
+  std::vector<std::uint8_t> neighbor_counts;
+  std::vector<std::size_t> changed;
+  std::vector<bool> is_candidate;
+  bool counts_valid = false;
+
+  // step_incremental()'s scratch lists, kept so every generation reuses
+  // their capacity instead of allocating
+  std::vector<std::size_t> candidates;
+  std::vector<std::size_t> flips;
 
   constexpr Automata(std::size_t width_, std::size_t height_, std::array<bool, 9> born_, std::array<bool, 9> survives_)
     : width(width_), height(height_), born(born_), survives(survives_) {}
@@ -43,9 +65,15 @@ struct Automata
     return floor_modulo(p.y, static_cast<index_t>(height)) * width + floor_modulo(p.x, static_cast<index_t>(width));
   }
 
-  [[nodiscard]] constexpr bool get(Point p) const { return data[index(p)]; }
+  [[nodiscard]] constexpr bool get(Point p) const { return data[index(p)] != 0; }
 
-  constexpr void set(Point p) { data[index(p)] = true; }
+  constexpr void set(Point p)
+  {
+    const auto cell = index(p);
+    if (!data[cell]) {
+      flip(cell);
+    }
+  }
 
   constexpr static std::array<Point, 8> neighbors{
     Point{ -1, -1 },
@@ -64,6 +92,100 @@ struct Automata
       neighbors, [&](auto offset) { return get(p + offset); }));
   }
 
+  [[nodiscard]] constexpr Point point(std::size_t cell) const
+  {
+    return Point{ static_cast<index_t>(cell % width), static_cast<index_t>(cell / width) };
+  }
+
+  constexpr void for_each_neighbor(std::size_t cell, auto func) const
+  {
+    const auto p = point(cell);
+    for (const auto offset : neighbors) {
+      func(index(p + offset));
+    }
+  }
+
+  // Toggles a cell, keeping the neighbor counts up to date if we have them
+  constexpr void flip(std::size_t cell)
+  {
+    const bool is_alive = data[cell] == 0;
+    data[cell] = is_alive;
+
+    if (counts_valid) {
+      for_each_neighbor(cell, [&](std::size_t neighbor) {
+        if (is_alive) {
+          ++neighbor_counts[neighbor];
+        } else {
+          --neighbor_counts[neighbor];
+        }
+      });
+      changed.push_back(cell);
+    }
+  }
+
+  // First step_incremental(): count everything once, and treat every cell
+  // as changed
+  constexpr void start_incremental()
+  {
+    neighbor_counts.assign(width * height, 0);
+    is_candidate.assign(width * height, false);
+    changed.clear();
+
+    for (std::size_t cell = 0; cell < width * height; ++cell) {
+      neighbor_counts[cell] = static_cast<std::uint8_t>(count_neighbors(point(cell)));
+      changed.push_back(cell);
+    }
+    counts_valid = true;
+  }
+
+  // Advances one generation in place. The work is proportional to how many
+  // cells changed last generation, not to the size of the board.
+  constexpr void step_incremental()
+  {
+    if (!counts_valid) {
+      start_incremental();
+    }
+
+    candidates.clear();
+    const auto add_candidate = [&](std::size_t cell) {
+      if (!is_candidate[cell]) {
+        is_candidate[cell] = true;
+        candidates.push_back(cell);
+      }
+    };
+
+    for (const auto cell : changed) {
+      add_candidate(cell);
+      for_each_neighbor(cell, add_candidate);
+    }
+
+    // decide everything from the current generation before touching it
+    flips.clear();
+    for (const auto cell : candidates) {
+      is_candidate[cell] = false;
+      const bool is_alive = data[cell] != 0;
+      const bool next_alive = is_alive ? survives[neighbor_counts[cell]] : born[neighbor_counts[cell]];
+      if (next_alive != is_alive) {
+        flips.push_back(cell);
+      }
+    }
+
+    changed.clear();
+    for (const auto cell : flips) {
+      flip(cell);
+    }
+  }
+
+  [[nodiscard]] constexpr bool next_alive(Point p) const
+  {
+    const auto neighbors = count_neighbors(p);
+    if (get(p)) {
+      return survives[neighbors];
+    } else {
+      return born[neighbors];
+    }
+  }
+
   [[nodiscard]] constexpr Automata next() const
   {
     Automata result{ width, height, born, survives };
@@ -71,21 +193,53 @@ struct Automata
     for (std::size_t y = 0; y < height; ++y) {
       for (std::size_t x = 0; x < width; ++x) {
         Point p{ static_cast<index_t>(x), static_cast<index_t>(y) };
-        const auto neighbors = count_neighbors(p);
-        if (get(p)) {
-          if (survives[neighbors]) {
-            result.set(p);
-          }
-        } else {
-          if (born[neighbors]) {
-            result.set(p);
-          }
+        if (next_alive(p)) {
+          result.set(p);
         }
       }
     }
 
     return result;
   }
+
+  // Advances n generations in place, ping-ponging between data and next_data.
+  // Nothing is allocated, and from Python this is one call per batch of
+  // generations instead of one call (and one new Automata) per generation.
+  //
+  // Same rule as next_alive(), but everything the loop needs is copied into
+  // locals first: the stores into next_data may alias any member, which
+  // would otherwise reload width and height (and redo the floor_modulo
+  // divisions) for every neighbor of every cell. The wraparound is worked
+  // out once per row and column instead.
+  constexpr void step(std::size_t n = 1)
+  {
+    const auto w = width;
+    const auto h = height;
+    const auto born_rule = born;
+    const auto survives_rule = survives;
+
+    for (std::size_t generation = 0; generation < n; ++generation) {
+      const auto *cells = data.data();
+      auto *next_cells = next_data.data();
+
+      for (std::size_t y = 0; y < h; ++y) {
+        const auto *above = cells + (y == 0 ? h - 1 : y - 1) * w;
+        const auto *middle = cells + y * w;
+        const auto *below = cells + (y + 1 == h ? 0 : y + 1) * w;
+
+        for (std::size_t x = 0; x < w; ++x) {
+          const auto west = x == 0 ? w - 1 : x - 1;
+          const auto east = x + 1 == w ? 0 : x + 1;
+          const auto count = static_cast<std::size_t>(above[west] + above[x] + above[east] + middle[west]
+                                                      + middle[east] + below[west] + below[x] + below[east]);
+          next_cells[y * w + x] = middle[x] != 0 ? survives_rule[count] : born_rule[count];
+        }
+      }
+      data.swap(next_data);
+    }
+    // we just replaced every cell behind step_incremental()'s back
+    counts_valid = false;
+  }
   constexpr void add_glider(Point p)
   {
     set(p);
@@ -102,9 +256,14 @@ int main()
 
   obj.add_glider(Automata::Point(0, 18));
 
+#ifdef INCREMENTAL
+  // -DINCREMENTAL, only the cells around the glider are ever looked at
   for (int i = 0; i < 10'000; ++i) {
-    obj = obj.next();
+    obj.step_incremental();
   }
+#else
+  obj.step(10'000);
+#endif
 
   for (size_t y = 0; y < obj.height; ++y) {
     for (size_t x = 0; x < obj.width; ++x) {